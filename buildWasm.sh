@@ -34,9 +34,9 @@ do
     echo building...
     if [ "$1" == "prod" ]
     then
-        emcc -c -std=c++17 -O3 -o ./wasmdist/obj/$fileName.o $i &
+        emcc -c -std=c++17 -O3 -msimd128 -o ./wasmdist/obj/$fileName.o $i &
     else
-        emcc -c -std=c++17 -g -gsource-map -o ./wasmdist/obj/$fileName.o $i &
+        emcc -c -std=c++17 -msimd128 -g -gsource-map -o ./wasmdist/obj/$fileName.o $i &
     fi
 
 done
@@ -2,18 +2,32 @@
 
 #include <vector>
 #include <string>
+#include <unordered_set>
+#include <unordered_map>
+#include <functional>
+#include <limits>
+#include <chrono>
+#include <cassert>
+#include <mutex>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define TINY_LAYOUT_ENGINE_WASM_SIMD
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TINY_LAYOUT_ENGINE_SSE2
+#endif
 
 namespace TinyLayoutEngine {
 
-BaseElement::BaseElement() {
+template<typename Coord>
+BasicStyle<Coord>::BasicStyle() {
+
+    borderWidth = 0;
+    borderRadius = 0;
 
-    width = LengthNone;
-    height = LengthNone;
-    maxWidth = LengthNone;
-    maxHeight = LengthNone;
-    minWidth = LengthNone;
-    minHeight = LengthNone;
-    
     paddingLeft = 0;
     paddingRight = 0;
     paddingTop = 0;
@@ -23,51 +37,220 @@ BaseElement::BaseElement() {
     marginTop = 0;
     marginBottom = 0;
 
-    grow = 0; 
-    zIndex = 0;
+    gap = 0; 
 
     backgroundColor = {0, 0, 0, 0}; // Default transparent
-
     borderColor = {0, 0, 0, 0}; // Default transparent
-    borderWidth = 0;
-    borderRadius = 0;
 
-    positioning = PositionFree;
     alignSelf = AlignStretch;
+    alignItems = AlignStretch;
+    justifyContent = JustifyStart;
+    layoutDirection = LayoutRow;
+    overflow = OverflowGrow;
+}
+
+template<typename Coord>
+bool BasicStyle<Coord>::operator==(const BasicStyle& other) const {
+    return borderWidth == other.borderWidth && borderRadius == other.borderRadius &&
+        paddingLeft == other.paddingLeft && paddingRight == other.paddingRight && 
+        paddingTop == other.paddingTop && paddingBottom == other.paddingBottom &&
+        marginLeft == other.marginLeft && marginRight == other.marginRight && 
+        marginTop == other.marginTop && marginBottom == other.marginBottom &&
+        gap == other.gap &&
+        backgroundColor.r == other.backgroundColor.r && backgroundColor.g == other.backgroundColor.g && 
+        backgroundColor.b == other.backgroundColor.b && backgroundColor.a == other.backgroundColor.a &&
+        borderColor.r == other.borderColor.r && borderColor.g == other.borderColor.g && 
+        borderColor.b == other.borderColor.b && borderColor.a == other.borderColor.a &&
+        alignSelf == other.alignSelf && alignItems == other.alignItems && justifyContent == other.justifyContent &&
+        layoutDirection == other.layoutDirection && overflow == other.overflow;
+}
+
+//
+//Style table, interned records and the handles pointing at them
+//
+
+template<typename Coord>
+struct StyleHasher {
+    size_t operator()(const BasicStyle<Coord>& style) const {
+        
+        //FNV-1a over the fields
+        size_t hash = 2166136261u;
+        const Coord lengths[11] = {
+            style.borderWidth, style.borderRadius, 
+            style.paddingLeft, style.paddingRight, style.paddingTop, style.paddingBottom,
+            style.marginLeft, style.marginRight, style.marginTop, style.marginBottom, style.gap
+        };
+        for(int i = 0; i < 11; i++) {
+            hash = (hash ^ std::hash<Coord>()(lengths[i])) * 16777619u;
+        }
+        const uint8_t bytes[13] = {
+            style.backgroundColor.r, style.backgroundColor.g, style.backgroundColor.b, style.backgroundColor.a,
+            style.borderColor.r, style.borderColor.g, style.borderColor.b, style.borderColor.a,
+            (uint8_t)style.alignSelf, (uint8_t)style.alignItems, (uint8_t)style.justifyContent, 
+            (uint8_t)style.layoutDirection, (uint8_t)style.overflow
+        };
+        for(int i = 0; i < 13; i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+};
+
+template<typename Coord>
+class StyleTable {
+public:
+    std::unordered_set<BasicStyle<Coord>, StyleHasher<Coord>> records; // Interned records, node based so the addresses are stable
+    std::vector<const BasicStyle<Coord>*> handles; // Record each handle currently points at
+    std::unordered_map<const BasicStyle<Coord>*, StyleHandle> sharedHandles; // Handle handed out by internStyle for each record
+
+    StyleTable() {
+        const BasicStyle<Coord>* defaultRecord = intern(BasicStyle<Coord>());
+        handles.push_back(defaultRecord);
+        sharedHandles[defaultRecord] = DefaultStyle;
+    }
+
+    const BasicStyle<Coord>* intern(const BasicStyle<Coord>& style) {
+        return &*records.insert(style).first;
+    }
+};
+
+template<typename Coord>
+StyleTable<Coord>& getStyleTable() {
+    static StyleTable<Coord> table;
+    return table;
+}
+
+template<typename Coord>
+StyleHandle internStyle(const BasicStyle<Coord>& style) {
+    StyleTable<Coord>& table = getStyleTable<Coord>();
+    const BasicStyle<Coord>* record = table.intern(style);
+
+    auto found = table.sharedHandles.find(record);
+    if(found != table.sharedHandles.end()) {
+        return found->second;
+    }
+
+    if(table.handles.size() > MaxStyleHandle) {
+        assert(false && "style table is out of handles");
+        return DefaultStyle;
+    }
+
+    StyleHandle handle = (StyleHandle)table.handles.size();
+    table.handles.push_back(record);
+    table.sharedHandles[record] = handle;
+    return handle;
+}
+
+template<typename Coord>
+StyleHandle createStyle(const BasicStyle<Coord>& style) {
+    StyleTable<Coord>& table = getStyleTable<Coord>();
+    if(table.handles.size() > MaxStyleHandle) {
+        assert(false && "style table is out of handles");
+        return DefaultStyle;
+    }
+
+    StyleHandle handle = (StyleHandle)table.handles.size();
+    table.handles.push_back(table.intern(style));
+    return handle;
+}
+
+template<typename Coord>
+void setStyle(StyleHandle handle, const BasicStyle<Coord>& style) {
+    StyleTable<Coord>& table = getStyleTable<Coord>();
+    if(handle >= table.handles.size()) {
+        assert(false && "setStyle on a handle that was never created");
+        return;
+    }
+    table.handles[handle] = table.intern(style);
+}
+
+template<typename Coord>
+const BasicStyle<Coord>* getStyle(StyleHandle handle) {
+    const StyleTable<Coord>& table = getStyleTable<Coord>();
+    assert(handle < table.handles.size() && "getStyle on a handle that was never created");
+    return table.handles[handle];
+}
+
+template<typename Coord>
+BasicBaseElement<Coord>::BasicBaseElement() {
+
+    width = LengthNone;
+    height = LengthNone;
+    maxWidth = LengthNone;
+    maxHeight = LengthNone;
+    minWidth = LengthNone;
+    minHeight = LengthNone;
+
+    style = DefaultStyle;
+
+    grow = 0; 
+    zIndex = 0;
+
+    positioning = PositionFree;
 
     visible = true; 
     displayed = true; 
-}
 
+    parent = nullptr;
+}
 
 
-Container::Container(){
-    elementType = ElementTypeContainer;
 
-    gap = 0; 
+template<typename Coord>
+BasicContainer<Coord>::BasicContainer(){
+    this->elementType = ElementTypeContainer;
+}
 
-    overflow = OverflowGrow;
+template<typename Coord>
+BasicGrid<Coord>::BasicGrid(){
+    this->elementType = ElementTypeGrid;
 
-    layoutDirection = LayoutRow;
-    justifyContent = JustifyStart;
-    alignItems = AlignStretch;
-    
+    columnCount = 1;
 }
 
-Text::Text() {
-    elementType = ElementTypeText;
+template<typename Coord>
+BasicText<Coord>::BasicText() {
+    this->elementType = ElementTypeText;
 
     text = "";
     color = {0, 0, 0}; // Default black
     textAlign = TextAlignLeft;
     font = 0; // Default font
+
+    measured = false;
+    maxContentWidth = 0;
+    minContentWidth = 0;
+
+    textBuffer = nullptr;
+    textSpan = {0, 0};
+
+    maxLines = 0;
+    truncated = false;
+    truncatedSpan = {0, 0};
 }
 
-Polygon::Polygon() {
-    elementType = ElementTypePolygon;
+template<typename Coord>
+BasicPolygon<Coord>::BasicPolygon() {
+    this->elementType = ElementTypePolygon;
 
     fill = false; 
     stroke = true; 
+
+    bounds[0] = bounds[1] = bounds[2] = bounds[3] = 0;
+    geometryBox[0] = geometryBox[1] = geometryBox[2] = geometryBox[3] = 0;
+    geometryStrokeWidth = 0;
+    geometryFill = false;
+    geometryValid = false;
+}
+
+LayoutContext::LayoutContext() {
+    
+    //start with a bit of room so small trees don't need to grow the buffers at all
+    words.reserve(64);
+    childLanes.reserve(256);
+    word.reserve(64);
+    currentLine.reserve(256);
+    testLine.reserve(256);
 }
 
 //Helper function to split a string by whitespace
@@ -79,721 +262,3178 @@ bool isSpace(char ch) {
     }
 }   
 
-std::vector<std::string> splitStringByWhitesp(std::string& s) {
-    std::vector<std::string> out;
-    const char* p   = s.data();
-    const char* end = p + s.size();
-
-    // (Optional) tiny heuristic reserve to reduce vector growth
-    out.reserve(8);
+//Writes the word spans into out, reusing its storage so no copies of the words are made
+void splitStringByWhitesp(const char* begin, size_t size, std::vector<TextSpan>& out) {
+    out.clear();
+    const char* p   = begin;
+    const char* end = p + size;
 
     while (p < end) {
         while (p < end && isSpace(static_cast<unsigned char>(*p))) ++p;
         const char* start = p;
         while (p < end && !isSpace(static_cast<unsigned char>(*p))) ++p;
-        if (start < p) out.emplace_back(start, static_cast<size_t>(p - start)); // one copy per token
+        if (start < p) out.push_back({static_cast<uint32_t>(start - begin), static_cast<uint32_t>(p - start)});
+    }
+}
+
+void splitStringByWhitesp(const std::string& s, std::vector<TextSpan>& out) {
+    splitStringByWhitesp(s.data(), s.size(), out);
+}
+
+//
+//External text. Debug builds keep a registry of the live buffers so an element left pointing at a destroyed buffer
+//is caught on the next layout instead of reading freed memory.
+//
+
+#ifndef NDEBUG
+std::mutex textBufferRegistryMutex;
+std::unordered_set<const TextBuffer*> textBufferRegistry;
+#endif
+
+TextBuffer::TextBuffer(const char* data, size_t size) {
+    this->data = data;
+    this->size = size;
+#ifndef NDEBUG
+    std::lock_guard<std::mutex> lock(textBufferRegistryMutex);
+    textBufferRegistry.insert(this);
+#endif
+}
+
+TextBuffer::~TextBuffer() {
+#ifndef NDEBUG
+    std::lock_guard<std::mutex> lock(textBufferRegistryMutex);
+    textBufferRegistry.erase(this);
+#endif
+}
+
+//Checks the lifetime contract of an element's external text, only in debug builds
+template<typename Coord>
+void checkTextBuffer(const BasicText<Coord>* textElement) {
+#ifndef NDEBUG
+    if(textElement->textBuffer != nullptr) {
+        std::lock_guard<std::mutex> lock(textBufferRegistryMutex);
+        assert(textBufferRegistry.count(textElement->textBuffer) && "text element references a destroyed TextBuffer");
+        assert((size_t)textElement->textSpan.offset + textElement->textSpan.length <= textElement->textBuffer->size && 
+            "text element span is outside its TextBuffer");
     }
+#else
+    (void)textElement;
+#endif
+}
+
+//The characters of a text element, its own string or its span of the external buffer
+template<typename Coord>
+const char* textData(const BasicText<Coord>* textElement) {
+    return textElement->textBuffer != nullptr ? textElement->textBuffer->data + textElement->textSpan.offset : textElement->text.data();
+}
+
+template<typename Coord>
+size_t textLength(const BasicText<Coord>* textElement) {
+    return textElement->textBuffer != nullptr ? textElement->textSpan.length : textElement->text.size();
+}
+
+template<typename Coord>
+size_t wrappedLineCount(const BasicText<Coord>* textElement) {
+    return textElement->textBuffer != nullptr ? textElement->wrappedSpans.size() : textElement->wrappedText.size();
+}
+
+template<typename Coord>
+Coord BasicMeasurementContext<Coord>::measureTextSpanWidth(const char* str, size_t length, uint8_t font) {
+    //one scratch string per thread so a warm layout doesn't allocate here
+    thread_local std::string text;
+    text.assign(str, length);
+    return measureTextWidth(text, font);
+}
 
-    return out;
+template<typename Coord>
+bool BasicMeasurementContext<Coord>::measureTextAdvances(const char*, size_t, uint8_t, Coord*) {
+    return false;
 }
 
 
+//Narrows an accumulated value back to the coordinate type, saturating for the integer types
+template<typename Coord>
+Coord toCoord(typename CoordTraits<Coord>::Accumulator value) {
+    if(std::numeric_limits<Coord>::is_integer) {
+        if(value > std::numeric_limits<Coord>::max()) return std::numeric_limits<Coord>::max();
+        if(value < std::numeric_limits<Coord>::lowest()) return std::numeric_limits<Coord>::lowest();
+    }
+    return (Coord)value;
+}
+
 //
 //zero out all widths and heights recursively 
 //
 
-void initElements(BaseElement* element){
+template<typename Coord>
+void initElements(BasicBaseElement<Coord>* element, BasicContainer<Coord>* parent){
     
     element->layout.width = 0;
     element->layout.height = 0;
+    element->parent = parent;
 
-    if(element->elementType == ElementTypeContainer){
-        Container* container = (Container*)element;
+    if(isContainerType(element->elementType)){
+        BasicContainer<Coord>* container = (BasicContainer<Coord>*)element;
         for(int i = 0; i < container->children.size(); i++){
-            initElements(container->children[i]);
+            initElements(container->children[i], container);
         }
     }
 }
 
 //
-//First pass, fit sizing, width using reverse breadth first pass. 
+//Polygon bounds. Polygons are sized by the bounds of their points, int16_t points are scanned 4 pairs at a time with 
+//SIMD min and max, the x and y values stay in alternating lanes so one pass gives both axes.
 //
 
-//compute the fit sizing for parents. 
-void computeWidthFitSizing(BaseElement* element, BaseMeasurementContext* measurementContext){
-
-    //go over children first if this element is a container
-    if(element->elementType == ElementTypeContainer){
-        Container* container = (Container*)element;
-        for(int i = 0; i < container->children.size(); i++){
-            computeWidthFitSizing(container->children[i], measurementContext);
-        }
+//left, top, right and bottom of x, y pairs, all 0 when there are no points
+template<typename Coord>
+void pointBounds(const Coord* points, int pointCount, Coord bounds[4]){
+    if(pointCount == 0) {
+        bounds[0] = bounds[1] = bounds[2] = bounds[3] = 0;
+        return;
+    }
+    bounds[0] = bounds[2] = points[0];
+    bounds[1] = bounds[3] = points[1];
+    for(int i = 1; i < pointCount; i++) {
+        bounds[0] = (std::min)(bounds[0], points[i * 2]);
+        bounds[1] = (std::min)(bounds[1], points[i * 2 + 1]);
+        bounds[2] = (std::max)(bounds[2], points[i * 2]);
+        bounds[3] = (std::max)(bounds[3], points[i * 2 + 1]);
     }
+}
 
-    //grab element settings related to the width
-    int16_t pl = element->paddingLeft;
-    int16_t pr = element->paddingRight;
-    int16_t blw = element->borderWidth;
-    int16_t brw = element->borderWidth;
-    int16_t sumSpace = pl + pr + blw + brw;
+inline void pointBounds(const int16_t* points, int pointCount, int16_t bounds[4]){
+    int valueCount = pointCount * 2;
+    if(valueCount < 16) {
+        pointBounds<int16_t>(points, pointCount, bounds);
+        return;
+    }
 
-    //add the padding and boarder to the width
-    element->layout.width = sumSpace;
-    element->layout.minWidth = sumSpace;
+    int i = 8;
+    int16_t lows[8];
+    int16_t highs[8];
+#if defined(TINY_LAYOUT_ENGINE_WASM_SIMD)
+    v128_t low = wasm_v128_load(points);
+    v128_t high = low;
+    for(; i + 8 <= valueCount; i += 8) {
+        v128_t values = wasm_v128_load(points + i);
+        low = wasm_i16x8_min(low, values);
+        high = wasm_i16x8_max(high, values);
+    }
+    wasm_v128_store(lows, low);
+    wasm_v128_store(highs, high);
+#elif defined(TINY_LAYOUT_ENGINE_SSE2)
+    __m128i low = _mm_loadu_si128((const __m128i*)points);
+    __m128i high = low;
+    for(; i + 8 <= valueCount; i += 8) {
+        __m128i values = _mm_loadu_si128((const __m128i*)(points + i));
+        low = _mm_min_epi16(low, values);
+        high = _mm_max_epi16(high, values);
+    }
+    _mm_storeu_si128((__m128i*)lows, low);
+    _mm_storeu_si128((__m128i*)highs, high);
+#else
+    for(int lane = 0; lane < 8; lane++) {
+        lows[lane] = highs[lane] = points[lane];
+    }
+    for(; i + 8 <= valueCount; i += 8) {
+        for(int lane = 0; lane < 8; lane++) {
+            lows[lane] = (std::min)(lows[lane], points[i + lane]);
+            highs[lane] = (std::max)(highs[lane], points[i + lane]);
+        }
+    }
+#endif
+
+    //even lanes hold x, odd lanes y, then the pairs that didn't fill a vector
+    bounds[0] = lows[0];
+    bounds[1] = lows[1];
+    bounds[2] = highs[0];
+    bounds[3] = highs[1];
+    for(int lane = 2; lane < 8; lane += 2) {
+        bounds[0] = (std::min)(bounds[0], lows[lane]);
+        bounds[1] = (std::min)(bounds[1], lows[lane + 1]);
+        bounds[2] = (std::max)(bounds[2], highs[lane]);
+        bounds[3] = (std::max)(bounds[3], highs[lane + 1]);
+    }
+    for(; i < valueCount; i += 2) {
+        bounds[0] = (std::min)(bounds[0], points[i]);
+        bounds[1] = (std::min)(bounds[1], points[i + 1]);
+        bounds[2] = (std::max)(bounds[2], points[i]);
+        bounds[3] = (std::max)(bounds[3], points[i + 1]);
+    }
+}
 
-    if(element->elementType == ElementTypeContainer){
-        Container* container = (Container*)element;
+//
+//Axis accessors. The fit and grow kernels are written once against these and instantiated for the x and y axis, 
+//so the field lookups are resolved at compile time.
+//
 
-        //now add the children's widths if the width is auto else just use the set width
-        if(element->width >= 0) { 
-            element->layout.width = element->width; 
-        }
-        else if(container->children.size() > 0) {
+//Measures the content width of a text element, the natural fully expanded size and the longest word
+template<typename Coord>
+void measureTextContentWidth(BasicText<Coord>* textElement, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext, 
+    bool needSize, bool needMinSize, typename CoordTraits<Coord>::Accumulator& size, typename CoordTraits<Coord>::Accumulator& minSize){
 
-            LayoutDirection layoutDirection = container->layoutDirection;
+    //Grab text settings for the elements
+    uint8_t font = textElement->font;
+    std::string& text = textElement->text;
 
-            //if the layout is row then add up all the children's widths + gaps
-            if(layoutDirection == LayoutRow){
-                for(int i = 0; i < container->children.size(); i++){
-                    BaseElement* child = container->children[i];
-                    element->layout.width += child->layout.width;
-                }
-                element->layout.width += (container->children.size() -1) * container->gap; 
-            }
+    //the measurement prepass already did the work
+    if(textElement->measured) {
+        size = textElement->maxContentWidth;
+        minSize = textElement->minContentWidth;
+        return;
+    }
 
-            //if column get the max width of the children
-            else {
+    //external text is measured in place
+    if(textElement->textBuffer != nullptr) {
+        checkTextBuffer(textElement);
+        const char* data = textData(textElement);
 
-                int16_t maxChildWidth = 0;
-                for(int i = 0; i < container->children.size(); i++){
-                    BaseElement* child = container->children[i];
-                    maxChildWidth = (std::max)(maxChildWidth, child->layout.width);
-                }
-                element->layout.width += maxChildWidth;
-            }
+        if(needSize) {
+            size = measurementContext->measureTextSpanWidth(data, textLength(textElement), font);
         }
+        if(needMinSize) {
+            std::vector<TextSpan>& textSplit = layoutContext->words;
+            splitStringByWhitesp(data, textLength(textElement), textSplit);
+            Coord longestWord = 0;
+
+            for(size_t i = 0; i < textSplit.size(); i++) {
+                Coord wordWidth = measurementContext->measureTextSpanWidth(data + textSplit[i].offset, textSplit[i].length, font);
+                longestWord = (std::max)(longestWord, wordWidth);
+            }
 
-        //now add the children's min widths
-        if(element->minWidth >= 0) {
-            element->layout.minWidth = element->minWidth;
+            minSize = longestWord;
         }
-        else if(container->children.size() > 0) {
-
-            LayoutDirection layoutDirection = container->layoutDirection;
+        return;
+    }
 
-            //if the layout is row then add up all the children's widths + gaps
-            if(layoutDirection == LayoutRow){
-                for(int i = 0; i < container->children.size(); i++){
-                    BaseElement* child = container->children[i];
-                    element->layout.minWidth += child->layout.minWidth;
-                }
-                element->layout.minWidth += (container->children.size() -1) * container->gap; 
-            }
+    if(needSize) {
+        size = measurementContext->measureTextWidth(text, font);
+    }
 
-            //if column get the max width of the children
-            else {
-                int16_t maxChildMinWidth = 0;
-                for(int i = 0; i < container->children.size(); i++){
-                    BaseElement* child = container->children[i];
-                    maxChildMinWidth = (std::max)(maxChildMinWidth, child->layout.minWidth);
-                }
-                element->layout.minWidth += maxChildMinWidth;
-            }
+    // Minimum width is the longest word
+    if(needMinSize) {
+        std::vector<TextSpan>& textSplit = layoutContext->words;
+        splitStringByWhitesp(text, textSplit);
+        Coord longestWord = 0;    
+
+        for(int i = 0; i < textSplit.size(); i++) {
+            std::string& word = layoutContext->word;
+            word.assign(text, textSplit[i].offset, textSplit[i].length);
+            Coord wordWidth = measurementContext->measureTextWidth(word, font);
+            longestWord = (std::max)(longestWord, wordWidth);
         }
 
+        minSize = longestWord;
     }
+}
 
-    else if(element->elementType == ElementTypeText){ 
+//Line spacing asked for by every pass that needs a line height, so they all agree
+//TODO: make this a property of the text element
+const int16_t TextLineSpacing = 1;
 
-        Text* textElement = (Text*)element;
-        
-        //Grab text settings for the elements
-        uint8_t font = textElement->font;
-        std::string text = textElement->text;
-        
-        //compute the width which is the natural fully expanded size of the text
-        if(element->width >= 0) {
-            element->layout.width = element->width;
-        }
-        else{
-            element->layout.width += measurementContext->measureTextWidth(text, font);   
-        }
-        
-        //Compute the min width which is the longest word in the text
-        if(element->minWidth >= 0) {
-            element->layout.minWidth = element->minWidth;
-        }
-        else {
-            // Minimum width is the longest word
-            std::vector<std::string> textSplit = splitStringByWhitesp(text);
-            int16_t minSize = 0;    
+//Measures the content height of a wrapped text element, the min height is just the height of the lines
+template<typename Coord>
+void measureTextContentHeight(BasicText<Coord>* textElement, BasicMeasurementContext<Coord>* measurementContext, 
+    typename CoordTraits<Coord>::Accumulator& size, typename CoordTraits<Coord>::Accumulator& minSize){
 
-            for(int i = 0; i < textSplit.size(); i++) {
-                std::string word = textSplit[i];
-                int16_t wordWidth = measurementContext->measureTextWidth(word, font);
-                minSize = (std::max)(minSize, wordWidth);
-            }
-            
-            element->layout.minWidth += minSize;
-        }
+    //Grab text settings for the elements
+    uint8_t font = textElement->font;
 
+    typename CoordTraits<Coord>::Accumulator contentH = 0; 
+    for(size_t i = 0; i < wrappedLineCount(textElement); i++) {
+        contentH += measurementContext->getLineHeight(TextLineSpacing, font);
     }
 
+    size = contentH;
+    minSize = contentH;
 }
 
-//
-//Second pass, Grow and shrink the widths. 
-//
-
-//function for growing and shrinking widths
-void computeWidthsGrowSizing(Container* parent){
-
-    //grab the paraents layout directions 
-    LayoutDirection layoutDirection = parent->layoutDirection;
+template<typename Coord>
+struct AxisX {
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
 
-    //grab element settings related to the width
-    int16_t pl = parent->paddingLeft;
-    int16_t pr = parent->paddingRight;
-    int16_t blw = parent->borderWidth;
-    int16_t brw = parent->borderWidth;
+    static const LayoutDirection mainDirection = LayoutRow; // Containers with this direction lay their children out along this axis
+    static const bool lazyMinSize = true; // Min widths need every word measured, they are only computed for shrinking
 
-    //Compute the initial value for available width
-    int16_t availableWidth = parent->layout.width;
-    availableWidth -= pl + pr + blw + brw;
+    static Coord& size(BasicBaseElement<Coord>* element) { return element->layout.width; }
+    static Coord& fitSize(BasicBaseElement<Coord>* element) { return element->layout.fitWidth; }
+    static Coord& minSize(BasicBaseElement<Coord>* element) { return element->layout.minWidth; }
+    static Coord fixedSize(BasicBaseElement<Coord>* element) { return element->width; }
+    static Coord fixedMinSize(BasicBaseElement<Coord>* element) { return element->minWidth; }
 
-    int16_t remainingWidth = availableWidth;
-    int16_t remainingMinWidth = availableWidth;
+    //padding plus border at the start and end of the axis
+    static Accum leadingSpace(const BasicStyle<Coord>* style) { return (Accum)style->paddingLeft + style->borderWidth; }
+    static Accum trailingSpace(const BasicStyle<Coord>* style) { return (Accum)style->paddingRight + style->borderWidth; }
 
-    //for row layouts, we distribute the remaining width among the children based on their flex grow
-    if(layoutDirection == LayoutRow){
+    static void measureTextContent(BasicText<Coord>* textElement, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext, 
+        bool needSize, bool needMinSize, Accum& size, Accum& minSize) {
+        measureTextContentWidth(textElement, measurementContext, layoutContext, needSize, needMinSize, size, minSize);
+    }
 
-        //compute the remaining width after subtracting all children's widths and the gaps
-        int childCount = parent->children.size();
-        int16_t gap = parent->gap;
-        if(childCount > 0) {
-            for(int i = 0; i < childCount; i++) {
-                BaseElement* child = parent->children[i];
-                remainingWidth -= child->layout.width;
-                remainingMinWidth -= child->layout.minWidth;
-                if(i < childCount -1){
-                    remainingWidth -= gap; 
-                    remainingMinWidth -= gap;
-                }
-            }
-        }
-            
-        //if there is remaining width we distribute it
-        if(remainingWidth >= 0){
+    //the width pass finds the bounds of the points, the height pass uses them
+    static void measurePolygonContent(BasicPolygon<Coord>* polygon, Accum& size) {
+        pointBounds(polygon->points.data(), (int)(polygon->points.size() / 2), polygon->bounds);
+        size = (Accum)polygon->bounds[2] - polygon->bounds[0];
+    }
 
-            //compute the sum of the children's grow factors 
-            int16_t flexGrowTotal = 0;
-            for(int i = 0; i < childCount; i++) {
-                BaseElement* child = parent->children[i];
-                int16_t childFlexGrow = child->grow;
-                flexGrowTotal += childFlexGrow;
-            }  
+    //grid tracks along this axis are the columns
+    static std::vector<Coord>& gridTracks(BasicGrid<Coord>* grid) { return grid->columnWidths; }
+    static std::vector<Coord>& gridMinTracks(BasicGrid<Coord>* grid) { return grid->columnMinWidths; }
+    static int gridTrackCount(int, int columnCount) { return columnCount; }
+    static int gridTrackOf(int cellIndex, int columnCount) { return cellIndex % columnCount; }
+};
+
+template<typename Coord>
+struct AxisY {
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
+
+    static const LayoutDirection mainDirection = LayoutColumn; // Containers with this direction lay their children out along this axis
+    static const bool lazyMinSize = false; // Min heights of text are its lines, they come with the fit for free
+
+    static Coord& size(BasicBaseElement<Coord>* element) { return element->layout.height; }
+    static Coord& fitSize(BasicBaseElement<Coord>* element) { return element->layout.fitHeight; }
+    static Coord& minSize(BasicBaseElement<Coord>* element) { return element->layout.minHeight; }
+    static Coord fixedSize(BasicBaseElement<Coord>* element) { return element->height; }
+    static Coord fixedMinSize(BasicBaseElement<Coord>* element) { return element->minHeight; }
+
+    //padding plus border at the start and end of the axis
+    static Accum leadingSpace(const BasicStyle<Coord>* style) { return (Accum)style->paddingTop + style->borderWidth; }
+    static Accum trailingSpace(const BasicStyle<Coord>* style) { return (Accum)style->paddingBottom + style->borderWidth; }
+
+    //the lines give both sizes at once, there are no flags to honour and no scratch to use
+    static void measureTextContent(BasicText<Coord>* textElement, BasicMeasurementContext<Coord>* measurementContext, LayoutContext*, 
+        bool, bool, Accum& size, Accum& minSize) {
+        measureTextContentHeight(textElement, measurementContext, size, minSize);
+    }
 
-            //distribute remaining width based on flex grow
-            for(int i = 0; i < childCount; i++) {
-                BaseElement* child = parent->children[i];
-                int16_t childFlexGrow = child->grow;
-                if(flexGrowTotal > 0 && childFlexGrow > 0) {
-                    int16_t remainingSpaceProportion = (remainingWidth * childFlexGrow) / flexGrowTotal;
-                    child->layout.width += remainingSpaceProportion;
-                }
-            }
-        }
+    static void measurePolygonContent(BasicPolygon<Coord>* polygon, Accum& size) {
+        size = (Accum)polygon->bounds[3] - polygon->bounds[1];
+    }
 
-        //if there is no remaining width we distribute the remaining width based on content grow
-        else if(remainingMinWidth >= 0){
-            
-            int16_t contentGrowTotal = 0;
-            for(int i = 0; i < childCount; i++) {
-                BaseElement* child = parent->children[i];
-                int16_t contentGrow = child->layout.width > (child->layout.minWidth) ? 1 : 0;
-                contentGrowTotal += contentGrow;
-            }   
+    //grid tracks along this axis are the rows
+    static std::vector<Coord>& gridTracks(BasicGrid<Coord>* grid) { return grid->rowHeights; }
+    static std::vector<Coord>& gridMinTracks(BasicGrid<Coord>* grid) { return grid->rowMinHeights; }
+    static int gridTrackCount(int cellCount, int columnCount) { return (cellCount + columnCount - 1) / columnCount; }
+    static int gridTrackOf(int cellIndex, int columnCount) { return cellIndex / columnCount; }
+};
 
-            for(int i = 0; i < childCount; i++) {
-                BaseElement* child = parent->children[i];
-                int16_t childContentGrow = child->layout.width > (child->layout.minWidth) ? 1 : 0;
-                if(contentGrowTotal > 0 && childContentGrow > 0) {
-                    int16_t remainingSpaceProportion = (remainingMinWidth * childContentGrow) / contentGrowTotal;
-                    child->layout.width = child->layout.minWidth + remainingSpaceProportion;
-                }
-            }
-        }
+//
+//First and fourth pass, fit sizing of the widths then the heights, children before parents.
+//
 
-        //if no remaining width, we shrink children proportionally
-        else {
+//Resolves a grid's tracks along the axis from its cells, each track is as big as its biggest cell.
+//This is one pass over the cells however many rows there are.
+template<typename Coord, typename Axis>
+void computeGridTracks(BasicGrid<Coord>* grid, const BasicStyle<Coord>* style, 
+    typename CoordTraits<Coord>::Accumulator& contentSize, typename CoordTraits<Coord>::Accumulator& minContentSize){
 
-            int16_t totalMinWidth = 0; 
-            for(int i = 0; i < childCount; i++) {
-                BaseElement* child = parent->children[i];
-                totalMinWidth += child->layout.minWidth;
-            }
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
 
-            for(int i = 0; i < childCount; i++) {
-                BaseElement* child = parent->children[i];
-                int16_t childMinWidth = child->layout.minWidth;
-                int16_t computedSize = (availableWidth * childMinWidth) / totalMinWidth;
-                child->layout.width = computedSize;
-            }
-        }
-    }
+    std::vector<BasicBaseElement<Coord>*>& cells = grid->children;
+    int cellCount = cells.size();
+    int columnCount = grid->columnCount > 0 ? grid->columnCount : 1;
+    int trackCount = Axis::gridTrackCount(cellCount, columnCount);
 
-    //For column layout, if the parent has the stretch alignment we increase the children's widths to fill the available space
-    else {
-        
-        Alignment parentAlignItems = parent->alignItems;
+    std::vector<Coord>& tracks = Axis::gridTracks(grid);
+    std::vector<Coord>& minTracks = Axis::gridMinTracks(grid);
+    tracks.assign(trackCount, 0);
 
-        int childCount = parent->children.size();
-        for(int i = 0; i < childCount; i++) {
-            BaseElement* child = parent->children[i];
+    //lazy min tracks are left empty until the grid has to shrink
+    if(Axis::lazyMinSize) minTracks.clear();
+    else minTracks.assign(trackCount, 0);
 
-            if(parentAlignItems == AlignStretch && (child->alignSelf == AlignAuto) || child->alignSelf == AlignStretch) {
-                child->layout.width = availableWidth;
-            }
+    for(int i = 0; i < cellCount; i++) {
+        int track = Axis::gridTrackOf(i, columnCount);
+        tracks[track] = (std::max)(tracks[track], Axis::fitSize(cells[i]));
+        if(!Axis::lazyMinSize) minTracks[track] = (std::max)(minTracks[track], Axis::minSize(cells[i]));
+    }
 
-            else if(availableWidth < child->layout.width ){
-                child->layout.width = availableWidth;
-            }                        
+    if(trackCount > 0) {
+        for(int i = 0; i < trackCount; i++) {
+            contentSize += tracks[i];
+            if(!Axis::lazyMinSize) minContentSize += minTracks[i];
         }
+        Accum gaps = (Accum)(trackCount - 1) * style->gap;
+        contentSize += gaps;
+        minContentSize += gaps;
     }
+}
 
-    //recur on children
-    int childCount = parent->children.size();
-    for(int i = 0; i < childCount; i++) {
-        BaseElement* child = parent->children[i];
+//compute the fit sizing of one element, its children must already be done
+template<typename Coord, typename Axis>
+void computeFitSizingNode(BasicBaseElement<Coord>* element, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
 
-        if(child->elementType == ElementTypeContainer) {
-            Container* childAsContainer = (Container*)child;
-            computeWidthsGrowSizing(childAsContainer);
-        }
-    }
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
 
-} 
+    //grab element settings related to this axis, the padding and border is added to the content
+    const BasicStyle<Coord>* style = getStyle<Coord>(element->style);
+    Accum sumSpace = Axis::leadingSpace(style) + Axis::trailingSpace(style);
 
-//
-//Third pass, Wrap the text. 
-//
+    Coord fixedSize = Axis::fixedSize(element);
+    Coord fixedMinSize = Axis::fixedMinSize(element);
 
-void computeTextWrapping(BaseElement* element, BaseMeasurementContext* measurementContext){
-    
-    if(element->elementType == ElementTypeText){
+    Accum contentSize = 0;
+    Accum minContentSize = 0;
+    bool needMinSize = !Axis::lazyMinSize && fixedMinSize < 0;
 
-        Text* textElement = (Text*)element;
+    if(element->elementType == ElementTypeGrid){
+        computeGridTracks<Coord, Axis>((BasicGrid<Coord>*)element, style, contentSize, minContentSize);
+    }
 
-        //Grab the text data
-        std::string text = textElement->text;
-        uint8_t font = textElement->font;
-        int16_t width = textElement->layout.width;
-        int16_t pl = element->paddingLeft; 
-        int16_t pr = element->paddingRight;
-        int16_t bw = element->borderWidth;
-        int16_t availableWidth = width - pl - pr - bw - bw; 
+    else if(element->elementType == ElementTypeContainer){
+        BasicContainer<Coord>* container = (BasicContainer<Coord>*)element;
+        std::vector<BasicBaseElement<Coord>*>& children = container->children;
+        int childCount = children.size();
 
-        //Compute the wrapped lines for the text in the accessible width
-        textElement->wrappedText.clear();
-        
-        std::vector<std::string> words = splitStringByWhitesp(text);
-        std::string currentLine = "";
-        int16_t currentLineWidth = 0;
+        if(childCount > 0) {
 
-        for(size_t i = 0; i < words.size(); i++){
-            std::string word = words[i];
-            
-            // Measure the width of the word (plus space if not first word)
-            std::string testLine = currentLine.empty() ? word : currentLine + " " + word;
-            int16_t testLineWidth = measurementContext->measureTextWidth(testLine, font);
-            
-            // If adding this word exceeds available width and current line is not empty
-            if(testLineWidth > availableWidth && !currentLine.empty()){
-                // Store the current line offset
-                textElement->wrappedText.push_back(currentLine);
-                
-                // Start new line with current word
-                currentLine = word;
-                currentLineWidth = measurementContext->measureTextWidth(word, font);
-            } else {
-                // Add word to current line
-                currentLine = testLine;
-                currentLineWidth = testLineWidth;
+            //if the container lays out along this axis then add up all the children's sizes + gaps
+            if(style->layoutDirection == Axis::mainDirection){
+                for(int i = 0; i < childCount; i++){
+                    contentSize += Axis::fitSize(children[i]);
+                }
+                if(needMinSize){
+                    for(int i = 0; i < childCount; i++){
+                        minContentSize += Axis::minSize(children[i]);
+                    }
+                }
+                Accum gaps = (Accum)(childCount - 1) * style->gap;
+                contentSize += gaps;
+                minContentSize += gaps;
+            }
+
+            //else get the max size of the children
+            else {
+                Coord maxChildSize = 0;
+                Coord maxChildMinSize = 0;
+                for(int i = 0; i < childCount; i++){
+                    maxChildSize = (std::max)(maxChildSize, Axis::fitSize(children[i]));
+                }
+                if(needMinSize){
+                    for(int i = 0; i < childCount; i++){
+                        maxChildMinSize = (std::max)(maxChildMinSize, Axis::minSize(children[i]));
+                    }
+                }
+                contentSize = maxChildSize;
+                minContentSize = maxChildMinSize;
             }
-        }
-        
-        // Add the last line if it's not empty
-        if(!currentLine.empty()){
-            textElement->wrappedText.push_back(currentLine);
-        }
-        
-        // Handle edge case where no words fit (single word too wide)
-        if(textElement->wrappedText.empty() && !words.empty()){
-            // Force at least one line, even if it overflows
-            textElement->wrappedText.push_back(words[0]);
         }
     }
 
-    //recur on children if this element is a container
-    if(element->elementType == ElementTypeContainer){
-        Container* container = (Container*)element;
-        for(int i = 0; i < container->children.size(); i++){
-            computeTextWrapping(container->children[i], measurementContext);
-        }
+    else if(element->elementType == ElementTypeText){ 
+        Axis::measureTextContent((BasicText<Coord>*)element, measurementContext, layoutContext, 
+            fixedSize < 0, needMinSize, contentSize, minContentSize);
     }
-}
 
-//
-//Forth pass, fit sizing, height using breadth first pass.
-//
+    //the points can be scaled down so a polygon has no min content size
+    else if(element->elementType == ElementTypePolygon){
+        Axis::measurePolygonContent((BasicPolygon<Coord>*)element, contentSize);
+    }
+
+    //a set size replaces the fit size, the fit size is kept apart so the parent can be refit after growing
+    Axis::size(element) = fixedSize >= 0 ? fixedSize : toCoord<Coord>(sumSpace + contentSize);
+    Axis::fitSize(element) = Axis::size(element);
+    Axis::minSize(element) = fixedMinSize >= 0 ? fixedMinSize : needMinSize ? toCoord<Coord>(sumSpace + minContentSize) : (Coord)LengthAuto;
+}
 
 //compute the fit sizing for parents. 
-void computeHeightFitSizing(BaseElement* element, BaseMeasurementContext* measurementContext){
+template<typename Coord, typename Axis>
+void computeFitSizing(BasicBaseElement<Coord>* element, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
 
     //go over children first if this element is a container
-    if(element->elementType == ElementTypeContainer){
-        Container* container = (Container*)element;
+    if(isContainerType(element->elementType)){
+        BasicContainer<Coord>* container = (BasicContainer<Coord>*)element;
         for(int i = 0; i < container->children.size(); i++){
-            computeWidthFitSizing(container->children[i], measurementContext);
+            computeFitSizing<Coord, Axis>(container->children[i], measurementContext, layoutContext);
         }
     }
 
-    //grab element settings related to the width
-    int16_t pt = element->paddingTop;
-    int16_t pb = element->paddingBottom;
-    int16_t btw = element->borderWidth;
-    int16_t bbw = element->borderWidth;
-    int16_t sumSpace = pt + pb + btw + bbw;
-
-    //add the padding and boarder to the width
-    element->layout.height = sumSpace;
-    element->layout.minHeight = sumSpace;
-
-    if(element->elementType == ElementTypeContainer){
-        Container* container = (Container*)element;
+    computeFitSizingNode<Coord, Axis>(element, measurementContext, layoutContext);
+}
 
-        //now add the children's heights if the height is auto else just use the set height 
-        if(element->height >= 0) { 
-            element->layout.height = element->height; 
-        }
-        else if(container->children.size() > 0) {
+template<typename Coord, typename Axis>
+Coord resolveMinSize(BasicBaseElement<Coord>* element, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext);
 
-            LayoutDirection layoutDirection = container->layoutDirection;
+//Min content size of each of a grid's tracks along the axis, the largest min size of its cells
+template<typename Coord, typename Axis>
+void computeGridMinTracks(BasicGrid<Coord>* grid, const BasicStyle<Coord>* style, BasicMeasurementContext<Coord>* measurementContext, 
+    LayoutContext* layoutContext, typename CoordTraits<Coord>::Accumulator& minContentSize){
 
-            //if the layout is column then add up all the children's heights + gaps
-            if(layoutDirection == LayoutColumn){
-                for(int i = 0; i < container->children.size(); i++){
-                    BaseElement* child = container->children[i];
-                    element->layout.height += child->layout.height;
-                }
-                element->layout.height += (container->children.size() -1) * container->gap; 
-            }
+    std::vector<BasicBaseElement<Coord>*>& cells = grid->children;
+    int cellCount = cells.size();
+    int columnCount = grid->columnCount > 0 ? grid->columnCount : 1;
+    int trackCount = Axis::gridTrackCount(cellCount, columnCount);
 
-            //if column get the max height of the children
-            else {
+    std::vector<Coord>& minTracks = Axis::gridMinTracks(grid);
+    minTracks.assign(trackCount, 0);
+    for(int i = 0; i < cellCount; i++) {
+        int track = Axis::gridTrackOf(i, columnCount);
+        minTracks[track] = (std::max)(minTracks[track], resolveMinSize<Coord, Axis>(cells[i], measurementContext, layoutContext));
+    }
 
-                int16_t maxChildHeight = 0;
-                for(int i = 0; i < container->children.size(); i++){
-                    BaseElement* child = container->children[i];
-                    maxChildHeight = (std::max)(maxChildHeight, child->layout.height);
-                }
-                element->layout.height += maxChildHeight;
-            }
+    if(trackCount > 0) {
+        for(int i = 0; i < trackCount; i++) {
+            minContentSize += minTracks[i];
         }
+        minContentSize += (typename CoordTraits<Coord>::Accumulator)(trackCount - 1) * style->gap;
+    }
+}
 
+//Min content size of an element along the axis. Lazy axes leave it out of the fit pass, it is computed here the first 
+//time a shrinking container asks for it, along with the min sizes of the subtree it needs, and kept in the layout.
+template<typename Coord, typename Axis>
+Coord resolveMinSize(BasicBaseElement<Coord>* element, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
 
-        //now add the children's min heights
-        if(element->minHeight >= 0) { 
-            element->layout.minHeight = element->minHeight; 
-        }
-        else if(container->children.size() > 0) {
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
 
-            LayoutDirection layoutDirection = container->layoutDirection;
+    if(Axis::minSize(element) >= 0) {
+        return Axis::minSize(element);
+    }
 
-            //if the layout is column then add up all the children's heights + gaps
-            if(layoutDirection == LayoutColumn){
-                for(int i = 0; i < container->children.size(); i++){
-                    BaseElement* child = container->children[i];
-                    element->layout.minHeight += child->layout.minHeight;
-                }
-                element->layout.minHeight += (container->children.size() -1) * container->gap; 
-            }
+    const BasicStyle<Coord>* style = getStyle<Coord>(element->style);
+    Accum minContentSize = 0;
 
-            //if column get the max height of the children
-            else {
+    if(element->elementType == ElementTypeGrid) {
+        computeGridMinTracks<Coord, Axis>((BasicGrid<Coord>*)element, style, measurementContext, layoutContext, minContentSize);
+    }
 
-                int16_t maxChildMinHeight = 0;
-                for(int i = 0; i < container->children.size(); i++){
-                    BaseElement* child = container->children[i];
-                    maxChildMinHeight = (std::max)(maxChildMinHeight, child->layout.minHeight);
-                }
-                element->layout.minHeight += maxChildMinHeight;
+    else if(element->elementType == ElementTypeContainer) {
+        std::vector<BasicBaseElement<Coord>*>& children = ((BasicContainer<Coord>*)element)->children;
+        int childCount = children.size();
+
+        if(style->layoutDirection == Axis::mainDirection) {
+            for(int i = 0; i < childCount; i++) {
+                minContentSize += resolveMinSize<Coord, Axis>(children[i], measurementContext, layoutContext);
             }
-        }
-    }
-
-    else if(element->elementType == ElementTypeText) {
-        
-        Text* textElement = (Text*)element;
-        
-        //Grab text settings for the elements
-        uint8_t font = textElement->font;
-        std::string text = textElement->text;
-        int16_t lineSpacing = 1; //TODO: make this a property of the text element
-        
-        //compute the height which is the natural line height of the text
-        if(element->height >= 0) {
-            element->layout.height += element->height;
-        }
-        else{
-            int16_t contentH = 0; 
-            for(int i = 0; i < textElement->wrappedText.size(); i++) {
-                contentH += measurementContext->getLineHeight(lineSpacing, font);
-            }
-            element->layout.height += contentH;
-        }
-        
-        //Compute the min height which is just the height of the text I think...
-        if(element->minHeight >= 0) {
-            element->layout.minHeight += element->minHeight;
+            if(childCount > 0) minContentSize += (Accum)(childCount - 1) * style->gap;
         }
         else {
-            element->layout.minHeight = element->layout.height; 
+            for(int i = 0; i < childCount; i++) {
+                minContentSize = (std::max)(minContentSize, (Accum)resolveMinSize<Coord, Axis>(children[i], measurementContext, layoutContext));
+            }
         }
+    }
 
+    else if(element->elementType == ElementTypeText) {
+        Accum contentSize = 0;
+        Axis::measureTextContent((BasicText<Coord>*)element, measurementContext, layoutContext, false, true, contentSize, minContentSize);
     }
+
+    Axis::minSize(element) = toCoord<Coord>(Axis::leadingSpace(style) + Axis::trailingSpace(style) + minContentSize);
+    return Axis::minSize(element);
 }
 
 //
-//Fifth pass, Grow and shrink the heights.
+//Wide container lanes. Containers with many children gather the child sizes into contiguous arrays, do the sums and 
+//the proportional distribution with SIMD (SSE2 or WASM SIMD128) and scatter the results back. int16_t coordinates 
+//use int32_t lanes, float coordinates use double lanes, int32_t coordinates stay on the scalar path.
 //
 
-//function for growing and shrinking heights
-void computeHeightsGrowSizing(Container* parent){
+const int WideContainerChildCount = 64; // Containers with at least this many children take the wide path
+
+//sum of the lanes
+inline int32_t sumLanes(const int32_t* values, int count){
+    int i = 0;
+    int32_t sum = 0;
+#if defined(TINY_LAYOUT_ENGINE_WASM_SIMD)
+    v128_t acc = wasm_i32x4_splat(0);
+    for(; i + 4 <= count; i += 4) acc = wasm_i32x4_add(acc, wasm_v128_load(values + i));
+    sum = wasm_i32x4_extract_lane(acc, 0) + wasm_i32x4_extract_lane(acc, 1) + wasm_i32x4_extract_lane(acc, 2) + wasm_i32x4_extract_lane(acc, 3);
+#elif defined(TINY_LAYOUT_ENGINE_SSE2)
+    __m128i acc = _mm_setzero_si128();
+    for(; i + 4 <= count; i += 4) acc = _mm_add_epi32(acc, _mm_loadu_si128((const __m128i*)(values + i)));
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for(; i < count; i++) sum += values[i];
+    return sum;
+}
 
-    //grab the paraents layout directions 
-    LayoutDirection layoutDirection = parent->layoutDirection;
-    
-    //grab element settings related to the height
-    int16_t pt = parent->paddingTop;
-    int16_t pb = parent->paddingBottom;
-    int16_t btw = parent->borderWidth;
-    int16_t bbw = parent->borderWidth;
+inline double sumLanes(const double* values, int count){
+    int i = 0;
+    double sum = 0;
+#if defined(TINY_LAYOUT_ENGINE_WASM_SIMD)
+    v128_t acc = wasm_f64x2_splat(0);
+    for(; i + 2 <= count; i += 2) acc = wasm_f64x2_add(acc, wasm_v128_load(values + i));
+    sum = wasm_f64x2_extract_lane(acc, 0) + wasm_f64x2_extract_lane(acc, 1);
+#elif defined(TINY_LAYOUT_ENGINE_SSE2)
+    __m128d acc = _mm_setzero_pd();
+    for(; i + 2 <= count; i += 2) acc = _mm_add_pd(acc, _mm_loadu_pd(values + i));
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    sum = lanes[0] + lanes[1];
+#endif
+    for(; i < count; i++) sum += values[i];
+    return sum;
+}
+
+//number of lanes where a is greater than b
+inline int32_t countGreaterLanes(const int32_t* a, const int32_t* b, int count){
+    int i = 0;
+    int32_t total = 0;
+#if defined(TINY_LAYOUT_ENGINE_WASM_SIMD)
+    v128_t acc = wasm_i32x4_splat(0);
+    for(; i + 4 <= count; i += 4) acc = wasm_i32x4_sub(acc, wasm_i32x4_gt(wasm_v128_load(a + i), wasm_v128_load(b + i)));
+    total = wasm_i32x4_extract_lane(acc, 0) + wasm_i32x4_extract_lane(acc, 1) + wasm_i32x4_extract_lane(acc, 2) + wasm_i32x4_extract_lane(acc, 3);
+#elif defined(TINY_LAYOUT_ENGINE_SSE2)
+    __m128i acc = _mm_setzero_si128();
+    for(; i + 4 <= count; i += 4) acc = _mm_sub_epi32(acc, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i))));
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for(; i < count; i++) total += a[i] > b[i] ? 1 : 0;
+    return total;
+}
+
+inline double countGreaterLanes(const double* a, const double* b, int count){
+    double total = 0;
+    for(int i = 0; i < count; i++) total += a[i] > b[i] ? 1 : 0;
+    return total;
+}
+
+//result = base + amount * weight / total rounded down, the division is done in doubles which is exact for int16_t coordinate ranges
+inline void proportionalLanes(const int32_t* base, const int32_t* weights, int count, int32_t amount, int32_t total, int32_t* result){
+    int i = 0;
+    double scale = (double)amount;
+    double divisor = (double)total;
+#if defined(TINY_LAYOUT_ENGINE_WASM_SIMD)
+    v128_t scaleLanes = wasm_f64x2_splat(scale);
+    v128_t divisorLanes = wasm_f64x2_splat(divisor);
+    for(; i + 2 <= count; i += 2) {
+        v128_t w = wasm_f64x2_convert_low_i32x4(wasm_v128_load64_zero(weights + i));
+        v128_t share = wasm_i32x4_trunc_sat_f64x2_zero(wasm_f64x2_div(wasm_f64x2_mul(w, scaleLanes), divisorLanes));
+        wasm_v128_store64_lane(result + i, wasm_i32x4_add(share, wasm_v128_load64_zero(base + i)), 0);
+    }
+#elif defined(TINY_LAYOUT_ENGINE_SSE2)
+    __m128d scaleLanes = _mm_set1_pd(scale);
+    __m128d divisorLanes = _mm_set1_pd(divisor);
+    for(; i + 2 <= count; i += 2) {
+        __m128d w = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i*)(weights + i)));
+        __m128i share = _mm_cvttpd_epi32(_mm_div_pd(_mm_mul_pd(w, scaleLanes), divisorLanes));
+        _mm_storel_epi64((__m128i*)(result + i), _mm_add_epi32(share, _mm_loadl_epi64((const __m128i*)(base + i))));
+    }
+#endif
+    for(; i < count; i++) result[i] = base[i] + (int32_t)((weights[i] * scale) / divisor);
+}
+
+inline void proportionalLanes(const double* base, const double* weights, int count, double amount, double total, double* result){
+    int i = 0;
+#if defined(TINY_LAYOUT_ENGINE_WASM_SIMD)
+    v128_t scaleLanes = wasm_f64x2_splat(amount);
+    v128_t divisorLanes = wasm_f64x2_splat(total);
+    for(; i + 2 <= count; i += 2) {
+        v128_t share = wasm_f64x2_div(wasm_f64x2_mul(wasm_v128_load(weights + i), scaleLanes), divisorLanes);
+        wasm_v128_store(result + i, wasm_f64x2_add(share, wasm_v128_load(base + i)));
+    }
+#elif defined(TINY_LAYOUT_ENGINE_SSE2)
+    __m128d scaleLanes = _mm_set1_pd(amount);
+    __m128d divisorLanes = _mm_set1_pd(total);
+    for(; i + 2 <= count; i += 2) {
+        __m128d share = _mm_div_pd(_mm_mul_pd(_mm_loadu_pd(weights + i), scaleLanes), divisorLanes);
+        _mm_storeu_pd(result + i, _mm_add_pd(share, _mm_loadu_pd(base + i)));
+    }
+#endif
+    for(; i < count; i++) result[i] = base[i] + (weights[i] * amount) / total;
+}
+
+//result = size > minSize ? minSize + share : size
+inline void contentGrowLanes(const int32_t* sizes, const int32_t* minSizes, int count, int32_t share, int32_t* result){
+    int i = 0;
+#if defined(TINY_LAYOUT_ENGINE_WASM_SIMD)
+    v128_t shareLanes = wasm_i32x4_splat(share);
+    for(; i + 4 <= count; i += 4) {
+        v128_t size = wasm_v128_load(sizes + i);
+        v128_t minSize = wasm_v128_load(minSizes + i);
+        v128_t grows = wasm_i32x4_gt(size, minSize);
+        wasm_v128_store(result + i, wasm_v128_bitselect(wasm_i32x4_add(minSize, shareLanes), size, grows));
+    }
+#elif defined(TINY_LAYOUT_ENGINE_SSE2)
+    __m128i shareLanes = _mm_set1_epi32(share);
+    for(; i + 4 <= count; i += 4) {
+        __m128i size = _mm_loadu_si128((const __m128i*)(sizes + i));
+        __m128i minSize = _mm_loadu_si128((const __m128i*)(minSizes + i));
+        __m128i grows = _mm_cmpgt_epi32(size, minSize);
+        __m128i grown = _mm_add_epi32(minSize, shareLanes);
+        _mm_storeu_si128((__m128i*)(result + i), _mm_or_si128(_mm_and_si128(grows, grown), _mm_andnot_si128(grows, size)));
+    }
+#endif
+    for(; i < count; i++) result[i] = sizes[i] > minSizes[i] ? minSizes[i] + share : sizes[i];
+}
+
+inline void contentGrowLanes(const double* sizes, const double* minSizes, int count, double share, double* result){
+    for(int i = 0; i < count; i++) result[i] = sizes[i] > minSizes[i] ? minSizes[i] + share : sizes[i];
+}
+
+//Picks the lane type and the scratch buffer for each coordinate type
+template<typename Coord> struct WideLanes { static const bool enabled = false; typedef int32_t Lane; };
+
+template<> struct WideLanes<int16_t> { 
+    static const bool enabled = true; 
+    typedef int32_t Lane;
+    static std::vector<int32_t>& buffer(LayoutContext* layoutContext) { return layoutContext->childLanes; }
+};
+
+template<> struct WideLanes<float> { 
+    static const bool enabled = true; 
+    typedef double Lane;
+    static std::vector<double>& buffer(LayoutContext* layoutContext) { return layoutContext->childLanesFloat; }
+};
+
+//
+//Second and fifth pass, Grow and shrink the widths then the heights, parents before children. 
+//
+
+//Hands the part of amount lost to rounding down back out, one unit each to the first children whose flag is set, 
+//so the distributed sizes add up to the space exactly. Nothing is left over for float coordinates.
+template<typename Coord, typename Size, typename Flag>
+void distributeRemainder(Size* sizes, const Flag* flags, int count, typename CoordTraits<Coord>::Accumulator leftover){
+    if(!std::numeric_limits<Coord>::is_integer) return;
+    for(int i = 0; i < count && leftover > 0; i++) {
+        if(flags[i] > 0) {
+            sizes[i] += 1;
+            leftover--;
+        }
+    }
+}
+
+//distribute the available space along the container's main axis, wide container version working on lanes
+template<typename Coord, typename Axis>
+void growMainAxisWide(BasicContainer<Coord>* parent, const BasicStyle<Coord>* style, Coord availableSize, 
+    BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
+
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
+    typedef typename WideLanes<Coord>::Lane Lane;
+
+    std::vector<BasicBaseElement<Coord>*>& children = parent->children;
+    int childCount = children.size();
 
-    //Compute the initial value for available width
-    int16_t availableHeight = parent->layout.height;
-    availableHeight -= pt + pb + btw + bbw;
+    //gather the children into four lanes, sizes, min sizes, grow factors and the results
+    std::vector<Lane>& buffer = WideLanes<Coord>::buffer(layoutContext);
+    buffer.resize(childCount * 4);
+    Lane* sizes = buffer.data();
+    Lane* minSizes = sizes + childCount;
+    Lane* grows = minSizes + childCount;
+    Lane* result = grows + childCount;
 
-    int16_t remainingHeight = availableHeight;
-    int16_t remainingMinHeight = availableHeight;
+    for(int i = 0; i < childCount; i++) {
+        BasicBaseElement<Coord>* child = children[i];
+        sizes[i] = Axis::size(child);
+        grows[i] = child->grow > 0 ? child->grow : 0;
+    }
 
-    //for column layouts, we distribute the remaining height among the children based on their flex grow
-    if(layoutDirection == LayoutColumn){
+    //compute the remaining space after subtracting all children's sizes and the gaps
+    Accum gaps = (Accum)(childCount - 1) * style->gap;
+    Accum remainingSize = availableSize - sumLanes(sizes, childCount) - gaps;
 
-        //compute the remaining height after subtracting all children's heights and the gaps
-        int childCount = parent->children.size();
-        int16_t gap = parent->gap;
+    //the min sizes are only needed to shrink
+    Accum remainingMinSize = 0;
+    if(remainingSize < 0) {
         for(int i = 0; i < childCount; i++) {
-            BaseElement* child = parent->children[i];
-            remainingHeight -= child->layout.height;
-            remainingMinHeight -= child->layout.minHeight;
-            if(i < childCount -1){
-                remainingHeight -= gap; 
-                remainingMinHeight -= gap;
+            minSizes[i] = resolveMinSize<Coord, Axis>(children[i], measurementContext, layoutContext);
+        }
+        remainingMinSize = availableSize - sumLanes(minSizes, childCount) - gaps;
+    }
+
+    //if there is remaining space we distribute it based on flex grow
+    if(remainingSize >= 0){
+        Accum flexGrowTotal = sumLanes(grows, childCount);
+        if(flexGrowTotal <= 0) return;
+
+        proportionalLanes(sizes, grows, childCount, (Lane)remainingSize, (Lane)flexGrowTotal, result);
+        Accum distributed = sumLanes(result, childCount) - sumLanes(sizes, childCount);
+        distributeRemainder<Coord>(result, grows, childCount, remainingSize - distributed);
+    }
+
+    //if there is no remaining space we distribute the remaining min space based on content grow
+    else if(remainingMinSize >= 0){
+        Accum contentGrowTotal = countGreaterLanes(sizes, minSizes, childCount);
+        if(contentGrowTotal <= 0) return;
+
+        Accum share = remainingMinSize / contentGrowTotal;
+        contentGrowLanes(sizes, minSizes, childCount, (Lane)share, result);
+        if(std::numeric_limits<Coord>::is_integer) {
+            Accum leftover = remainingMinSize - share * contentGrowTotal;
+            for(int i = 0; i < childCount && leftover > 0; i++) {
+                if(sizes[i] > minSizes[i]) {
+                    result[i] += 1;
+                    leftover--;
+                }
             }
         }
-        
-        
-        //if there is remaining height we distribute it
-        if(remainingHeight >= 0){
+    }
 
-            //compute the sum of the children's grow factors 
-            int16_t flexGrowTotal = 0;
-            for(int i = 0; i < childCount; i++) {
-                BaseElement* child = parent->children[i];
-                int16_t childFlexGrow = child->grow;
-                flexGrowTotal += childFlexGrow;
-            }  
+    //if no remaining space, we shrink children proportionally
+    else {
+        Accum totalMinSize = sumLanes(minSizes, childCount);
+        if(totalMinSize <= 0) return;
+
+        for(int i = 0; i < childCount; i++) sizes[i] = 0;
+        proportionalLanes(sizes, minSizes, childCount, (Lane)availableSize, (Lane)totalMinSize, result);
+        distributeRemainder<Coord>(result, minSizes, childCount, availableSize - sumLanes(result, childCount));
+    }
 
-            //distribute remaining height based on flex grow
+    //scatter the results back to the children
+    for(int i = 0; i < childCount; i++) {
+        Axis::size(children[i]) = toCoord<Coord>(result[i]);
+    }
+}
+
+//distribute the available space along the container's main axis
+template<typename Coord, typename Axis>
+void growMainAxis(BasicContainer<Coord>* parent, const BasicStyle<Coord>* style, Coord availableSize, 
+    BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
+
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
+
+    std::vector<BasicBaseElement<Coord>*>& children = parent->children;
+    int childCount = children.size();
+    Coord gap = style->gap;
+
+    if constexpr(WideLanes<Coord>::enabled) {
+        if(childCount >= WideContainerChildCount) {
+            growMainAxisWide<Coord, Axis>(parent, style, availableSize, measurementContext, layoutContext);
+            return;
+        }
+    }
+
+    //compute the remaining space after subtracting all children's sizes and the gaps
+    Accum remainingSize = availableSize;
+    for(int i = 0; i < childCount; i++) {
+        remainingSize -= Axis::size(children[i]);
+    }
+    if(childCount > 0) {
+        remainingSize -= (Accum)(childCount - 1) * gap; 
+    }
+
+    //the min sizes are only needed to shrink, most containers never get here
+    Accum remainingMinSize = 0;
+    if(remainingSize < 0) {
+        remainingMinSize = availableSize;
+        for(int i = 0; i < childCount; i++) {
+            remainingMinSize -= resolveMinSize<Coord, Axis>(children[i], measurementContext, layoutContext);
+        }
+        if(childCount > 0) {
+            remainingMinSize -= (Accum)(childCount - 1) * gap;
+        }
+    }
+
+    //if there is remaining space we distribute it
+    if(remainingSize >= 0){
+
+        //compute the sum of the children's grow factors 
+        Accum flexGrowTotal = 0;
+        for(int i = 0; i < childCount; i++) {
+            if(children[i]->grow > 0) flexGrowTotal += children[i]->grow;
+        }  
+
+        //distribute remaining space based on flex grow, each share is rounded down and the remainder handed out after
+        if(flexGrowTotal > 0) {
+            Accum leftover = remainingSize;
             for(int i = 0; i < childCount; i++) {
-                BaseElement* child = parent->children[i];
-                int16_t childFlexGrow = child->grow;
-                if(flexGrowTotal > 0 && childFlexGrow > 0) {
-                    int16_t remainingSpaceProportion = (remainingHeight * childFlexGrow) / flexGrowTotal;
-                    child->layout.height += remainingSpaceProportion;
+                BasicBaseElement<Coord>* child = children[i];
+                Accum childFlexGrow = child->grow;
+                if(childFlexGrow > 0) {
+                    Accum remainingSpaceProportion = (remainingSize * childFlexGrow) / flexGrowTotal;
+                    Axis::size(child) = toCoord<Coord>(Axis::size(child) + remainingSpaceProportion);
+                    leftover -= remainingSpaceProportion;
+                }
+            }
+
+            if(std::numeric_limits<Coord>::is_integer) {
+                for(int i = 0; i < childCount && leftover > 0; i++) {
+                    if(children[i]->grow > 0) {
+                        Axis::size(children[i]) += 1;
+                        leftover--;
+                    }
                 }
             }
         }
+    }
 
-        //if there is no remaining height we distribute the remaining height based on content grow
-        else if(remainingMinHeight >= 0){
-            
-            int16_t contentGrowTotal = 0;
-            for(int i = 0; i < childCount; i++) {
-                BaseElement* child = parent->children[i];
-                int16_t contentGrow = child->layout.height > (child->layout.minHeight) ? 1 : 0;
-                contentGrowTotal += contentGrow;
-            }   
+    //if there is no remaining space we distribute the remaining min space based on content grow
+    else if(remainingMinSize >= 0){
+        
+        Accum contentGrowTotal = 0;
+        for(int i = 0; i < childCount; i++) {
+            BasicBaseElement<Coord>* child = children[i];
+            contentGrowTotal += Axis::size(child) > Axis::minSize(child) ? 1 : 0;
+        }   
 
+        if(contentGrowTotal > 0) {
+            Accum remainingSpaceProportion = remainingMinSize / contentGrowTotal;
+            Accum leftover = remainingMinSize - remainingSpaceProportion * contentGrowTotal;
             for(int i = 0; i < childCount; i++) {
-                BaseElement* child = parent->children[i];
-                int16_t childContentGrow = child->layout.height > (child->layout.minHeight) ? 1 : 0;
-                if(contentGrowTotal > 0 && childContentGrow > 0) {
-                    int16_t remainingSpaceProportion = (remainingMinHeight * childContentGrow) / contentGrowTotal;
-                    child->layout.height = child->layout.minHeight + remainingSpaceProportion;
+                BasicBaseElement<Coord>* child = children[i];
+                if(Axis::size(child) > Axis::minSize(child)) {
+                    Accum extra = 0;
+                    if(std::numeric_limits<Coord>::is_integer && leftover > 0) {
+                        extra = 1;
+                        leftover--;
+                    }
+                    Axis::size(child) = toCoord<Coord>(Axis::minSize(child) + remainingSpaceProportion + extra);
                 }
             }
         }
+    }
 
-        //if no remaining height, we shrink children proportionally
-        else {
+    //if no remaining space, we shrink children proportionally
+    else {
+
+        Accum totalMinSize = 0; 
+        for(int i = 0; i < childCount; i++) {
+            totalMinSize += Axis::minSize(children[i]);
+        }
 
-            int16_t totalMinHeight = 0; 
+        if(totalMinSize > 0) {
+            Accum leftover = availableSize;
             for(int i = 0; i < childCount; i++) {
-                BaseElement* child = parent->children[i];
-                totalMinHeight += child->layout.minHeight;
+                BasicBaseElement<Coord>* child = children[i];
+                Axis::size(child) = toCoord<Coord>(((Accum)availableSize * Axis::minSize(child)) / totalMinSize);
+                leftover -= Axis::size(child);
             }
 
-            for(int i = 0; i < childCount; i++) {
-                BaseElement* child = parent->children[i];
-                int16_t childMinHeight = child->layout.minHeight;
-                int16_t computedSize = (availableHeight * childMinHeight) / totalMinHeight;
-                child->layout.height = computedSize;
+            if(std::numeric_limits<Coord>::is_integer) {
+                for(int i = 0; i < childCount && leftover > 0; i++) {
+                    if(Axis::minSize(children[i]) > 0) {
+                        Axis::size(children[i]) += 1;
+                        leftover--;
+                    }
+                }
             }
         }
     }
+}
 
-    //For column layout, if the parent has the stretch alignment we increase the children's height to fill the available space
-    else {
-        
-        Alignment parentAlignItems = parent->alignItems;
+//Shrinks a grid's tracks along the axis when they don't fit, using the same rules as the flex shrink, 
+//then sizes every cell from its track. Spare space is left after the last track.
+template<typename Coord, typename Axis>
+void growGridTracks(BasicGrid<Coord>* grid, const BasicStyle<Coord>* style, Coord availableSize, 
+    BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
 
-        int childCount = parent->children.size();
-        for(int i = 0; i < childCount; i++) {
-            BaseElement* child = parent->children[i];
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
+
+    std::vector<Coord>& tracks = Axis::gridTracks(grid);
+    std::vector<Coord>& minTracks = Axis::gridMinTracks(grid);
+    int trackCount = tracks.size();
+
+    Accum remainingSize = availableSize;
+    for(int i = 0; i < trackCount; i++) {
+        remainingSize -= tracks[i];
+    }
+    if(trackCount > 0) {
+        remainingSize -= (Accum)(trackCount - 1) * style->gap;
+    }
+
+    //the min tracks are only needed to shrink, lazy ones are computed now unless the grid's min size already did
+    Accum remainingMinSize = availableSize;
+    if(remainingSize < 0) {
+        Accum minContentSize = 0;
+        if((int)minTracks.size() != trackCount) {
+            computeGridMinTracks<Coord, Axis>(grid, style, measurementContext, layoutContext, minContentSize);
+        }
+        for(int i = 0; i < trackCount; i++) {
+            remainingMinSize -= minTracks[i];
+        }
+        if(trackCount > 0) {
+            remainingMinSize -= (Accum)(trackCount - 1) * style->gap;
+        }
+    }
+
+    //shrink the tracks that are bigger than their min size evenly
+    if(remainingSize < 0 && remainingMinSize >= 0) {
+        Accum contentGrowTotal = 0;
+        for(int i = 0; i < trackCount; i++) {
+            contentGrowTotal += tracks[i] > minTracks[i] ? 1 : 0;
+        }
+
+        if(contentGrowTotal > 0) {
+            Accum share = remainingMinSize / contentGrowTotal;
+            Accum leftover = remainingMinSize - share * contentGrowTotal;
+            for(int i = 0; i < trackCount; i++) {
+                if(tracks[i] > minTracks[i]) {
+                    Accum extra = 0;
+                    if(std::numeric_limits<Coord>::is_integer && leftover > 0) {
+                        extra = 1;
+                        leftover--;
+                    }
+                    tracks[i] = toCoord<Coord>(minTracks[i] + share + extra);
+                }
+            }
+        }
+    }
+
+    //shrink all tracks in proportion to their min size
+    else if(remainingSize < 0) {
+        Accum totalMinSize = 0;
+        for(int i = 0; i < trackCount; i++) {
+            totalMinSize += minTracks[i];
+        }
 
-            if(parentAlignItems == AlignStretch && (child->alignSelf == AlignAuto) || child->alignSelf == AlignStretch) {
-                child->layout.height = availableHeight;
+        if(totalMinSize > 0) {
+            Accum leftover = availableSize;
+            for(int i = 0; i < trackCount; i++) {
+                tracks[i] = toCoord<Coord>(((Accum)availableSize * minTracks[i]) / totalMinSize);
+                leftover -= tracks[i];
             }
+            distributeRemainder<Coord>(tracks.data(), minTracks.data(), trackCount, leftover);
+        }
+    }
+
+    //cells stretch to fill their track unless they are aligned
+    Alignment gridAlignItems = style->alignItems;
+    std::vector<BasicBaseElement<Coord>*>& cells = grid->children;
+    int cellCount = cells.size();
+    int columnCount = grid->columnCount > 0 ? grid->columnCount : 1;
+    for(int i = 0; i < cellCount; i++) {
+        BasicBaseElement<Coord>* cell = cells[i];
+        Coord trackSize = tracks[Axis::gridTrackOf(i, columnCount)];
+
+        Alignment cellAlignSelf = getStyle<Coord>(cell->style)->alignSelf;
+        if((gridAlignItems == AlignStretch && (cellAlignSelf == AlignAuto)) || cellAlignSelf == AlignStretch) {
+            Axis::size(cell) = trackSize;
+        }
+        else if(trackSize < Axis::size(cell)) {
+            Axis::size(cell) = trackSize;
+        }
+    }
+}
+
+//stretch or clamp the children across the container's cross axis, from firstChild on
+template<typename Coord, typename Axis>
+void stretchCrossAxis(BasicContainer<Coord>* parent, const BasicStyle<Coord>* style, Coord availableSize, int firstChild = 0){
+
+    Alignment parentAlignItems = style->alignItems;
+    
+    std::vector<BasicBaseElement<Coord>*>& children = parent->children;
+    int childCount = children.size();
+    for(int i = firstChild; i < childCount; i++) {
+        BasicBaseElement<Coord>* child = children[i];
+
+        Alignment childAlignSelf = getStyle<Coord>(child->style)->alignSelf;
 
-            else if(availableHeight < child->layout.height ){
-                child->layout.height = availableHeight;
-            }                        
+        if((parentAlignItems == AlignStretch && (childAlignSelf == AlignAuto)) || childAlignSelf == AlignStretch) {
+            Axis::size(child) = availableSize;
         }
+
+        else if(availableSize < Axis::size(child)){
+            Axis::size(child) = availableSize;
+        }                        
+    }
+}
+
+//grows and shrinks the children of one container along one axis
+template<typename Coord, typename Axis>
+void computeGrowSizingNode(BasicContainer<Coord>* parent, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
+
+    //Compute the available space inside the padding and border
+    const BasicStyle<Coord>* style = getStyle<Coord>(parent->style);
+    Coord availableSize = toCoord<Coord>(Axis::size(parent) - (Axis::leadingSpace(style) + Axis::trailingSpace(style)));
+
+    //the direction only has to be checked once per container
+    if(parent->elementType == ElementTypeGrid) {
+        growGridTracks<Coord, Axis>((BasicGrid<Coord>*)parent, style, availableSize, measurementContext, layoutContext);
+    }
+    else if(style->layoutDirection == Axis::mainDirection) {
+        growMainAxis<Coord, Axis>(parent, style, availableSize, measurementContext, layoutContext);
+    }
+    else {
+        stretchCrossAxis<Coord, Axis>(parent, style, availableSize);
     }
+}
+
+//function for growing and shrinking along one axis
+template<typename Coord, typename Axis>
+void computeGrowSizing(BasicContainer<Coord>* parent, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
+
+    computeGrowSizingNode<Coord, Axis>(parent, measurementContext, layoutContext);
 
     //recur on children
     int childCount = parent->children.size();
     for(int i = 0; i < childCount; i++) {
-        BaseElement* child = parent->children[i];
-        if(child->elementType == ElementTypeContainer) {
-            Container* childAsContainer = (Container*)child;
-            computeHeightsGrowSizing(childAsContainer);
+        BasicBaseElement<Coord>* child = parent->children[i];
+
+        if(isContainerType(child->elementType)) {
+            computeGrowSizing<Coord, Axis>((BasicContainer<Coord>*)child, measurementContext, layoutContext);
         }
     }
 } 
 
-
 //
-//Sixth pass, Position elements
+//Third pass, Wrap the text. 
 //
 
-void computePositions(Container* parent){
+//Truncation. The last line is cut where the text plus an ellipsis still fits, found with a binary search over the 
+//advances of the line up to the word that overflowed so it costs one measurement, or over measured prefixes when the 
+//context can't give advances.
+
+const char Ellipsis[] = "\xE2\x80\xA6";
+const size_t EllipsisLength = 3;
+
+//Picks the advance buffer for each coordinate type
+template<typename Coord> struct CharacterAdvances;
+template<> struct CharacterAdvances<int16_t> { 
+    static std::vector<int16_t>& buffer(LayoutContext* layoutContext) { return layoutContext->characterAdvances; }
+};
+template<> struct CharacterAdvances<int32_t> { 
+    static std::vector<int32_t>& buffer(LayoutContext* layoutContext) { return layoutContext->characterAdvances32; }
+};
+template<> struct CharacterAdvances<float> { 
+    static std::vector<float>& buffer(LayoutContext* layoutContext) { return layoutContext->characterAdvancesFloat; }
+};
+
+//Picks the buffer for the layouts layoutAppended compares against for each coordinate type
+template<typename Coord> struct PreviousLayouts;
+template<> struct PreviousLayouts<int16_t> { 
+    static std::vector<BasicComputedLayout<int16_t>>& buffer(LayoutContext* layoutContext) { return layoutContext->previousLayouts; }
+};
+template<> struct PreviousLayouts<int32_t> { 
+    static std::vector<BasicComputedLayout<int32_t>>& buffer(LayoutContext* layoutContext) { return layoutContext->previousLayouts32; }
+};
+template<> struct PreviousLayouts<float> { 
+    static std::vector<BasicComputedLayout<float>>& buffer(LayoutContext* layoutContext) { return layoutContext->previousLayoutsFloat; }
+};
+
+//moves a cut back so it doesn't split a UTF-8 character
+size_t characterStart(const char* str, size_t length, size_t cut) {
+    while(cut > 0 && cut < length && ((uint8_t)str[cut] & 0xC0) == 0x80) cut--;
+    return cut;
+}
 
-    //grab the paraents layout directions 
-    LayoutDirection layoutDirection = parent->layoutDirection;
+//Cuts the text from begin to end so it fits in availableWidth with an ellipsis after it, returns the part that is 
+//kept without its trailing whitespace
+template<typename Coord>
+TextSpan truncateRun(const char* data, uint32_t begin, uint32_t end, uint8_t font, Coord availableWidth, 
+    BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
+
+    const char* run = data + begin;
+    size_t length = end - begin;
+    std::string& word = layoutContext->word;
+    word.assign(Ellipsis, EllipsisLength);
+    Coord limit = availableWidth - measurementContext->measureTextWidth(word, font);
+    size_t kept;
+
+    std::vector<Coord>& advances = CharacterAdvances<Coord>::buffer(layoutContext);
+    advances.resize(length);
+    if(length > 0 && measurementContext->measureTextAdvances(run, length, font, advances.data())) {
+        //the advances only grow, every byte up to the first one past the limit fits
+        kept = std::upper_bound(advances.begin(), advances.end(), limit) - advances.begin();
+    }
+    else {
+        //the longest prefix that fits, each probe is copied into the scratch word so nothing is allocated
+        size_t low = 0;
+        size_t high = length;
+        while(low < high) {
+            size_t middle = low + (high - low + 1) / 2;
+            size_t cut = characterStart(run, length, middle);
+            if(cut > 0) word.assign(run, cut);
+            if(cut == 0 || measurementContext->measureTextWidth(word, font) <= limit) low = middle;
+            else high = middle - 1;
+        }
+        kept = characterStart(run, length, low);
+    }
 
-    //grab parent data 
-    int16_t pl = parent->paddingLeft;
-    int16_t pr = parent->paddingRight;
-    int16_t blw = parent->borderWidth;
-    int16_t brw = parent->borderWidth;
-    int16_t x = parent->layout.x;
-    int16_t width = parent->layout.width;
-
-    int16_t pt = parent->paddingTop;
-    int16_t pb = parent->paddingBottom;
-    int16_t btw = parent->borderWidth;
-    int16_t bbw = parent->borderWidth;
-    int16_t y = parent->layout.y;
-    int16_t height = parent->layout.height;
-
-    Alignment parentAlignItems = parent->alignItems;
-    
-    int16_t gap = parent->gap;
+    while(kept > 0 && isSpace(run[kept - 1])) kept--;
+    return {begin, (uint32_t)kept};
+}
 
-    int childCount = parent->children.size();
+//Wraps external text without copying it, a line is measured as the span from its first word to its last
+template<typename Coord>
+void wrapTextSpans(BasicText<Coord>* textElement, Coord availableWidth, size_t maxLines, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
 
-    //position elements horizontally
-    int16_t currentHOffset = 0;
-    
-    if(layoutDirection == LayoutRow) {
-        for(int i = 0; i < childCount; i++) {
-            BaseElement* child = parent->children[i];
-            child->layout.x = x + pl + blw + currentHOffset;
-            currentHOffset += child->layout.width + gap; 
+    checkTextBuffer(textElement);
+    const char* data = textData(textElement);
+    uint8_t font = textElement->font;
+
+    std::vector<TextSpan>& words = layoutContext->words;
+    splitStringByWhitesp(data, textLength(textElement), words);
+
+    //spans are kept relative to the buffer so a line stays valid when the element is split
+    std::vector<TextSpan>& wrappedSpans = textElement->wrappedSpans;
+    wrappedSpans.clear();
+    textElement->wrappedText.clear();
+
+    uint32_t lineStart = 0;
+    uint32_t lineEnd = 0;
+    bool lineEmpty = true;
+    Coord lineWidth = 0;
+    bool cut = false;
+    size_t cutWord = 0;
+
+    for(size_t i = 0; i < words.size(); i++){
+        uint32_t wordEnd = words[i].offset + words[i].length;
+
+        Coord testLineWidth;
+        if(lineEmpty) {
+            testLineWidth = textElement->measured ? textElement->wordAdvances[i] : 
+                measurementContext->measureTextSpanWidth(data + words[i].offset, words[i].length, font);
+        }
+        else {
+            testLineWidth = measurementContext->measureTextSpanWidth(data + lineStart, wordEnd - lineStart, font);
         }
-    }
-    else {
-        for(int i = 0; i < childCount; i++) {
-            BaseElement* child = parent->children[i];
-            child->layout.x = x + pl + blw;
 
-            if(parentAlignItems == AlignCenter && !child->alignSelf || child->alignSelf == AlignCenter){
-                child->layout.x += (width - pl - blw - pr - brw - child->layout.width) / 2;
+        if(testLineWidth > availableWidth && !lineEmpty){
+            //the last line allowed and there are words left, it is cut below
+            if(wrappedSpans.size() + 1 == maxLines) {
+                cut = true;
+                cutWord = i;
+                break;
             }
-            else if(parentAlignItems == AlignEnd && !child->alignSelf || child->alignSelf == AlignEnd){
-                child->layout.x += (width - pl - blw - pr - brw - child->layout.width);
+            wrappedSpans.push_back({textElement->textSpan.offset + lineStart, lineEnd - lineStart});
+            lineStart = words[i].offset;
+
+            //the width of the new line is only needed to know if its word has to be cut
+            if(maxLines > 0) {
+                testLineWidth = textElement->measured ? textElement->wordAdvances[i] : 
+                    measurementContext->measureTextSpanWidth(data + words[i].offset, words[i].length, font);
             }
         }
+        else if(lineEmpty) {
+            lineStart = words[i].offset;
+        }
+        lineEnd = wordEnd;
+        lineEmpty = false;
+        lineWidth = testLineWidth;
     }
 
-    //position elements vertically
-    int16_t currentVOffset = 0;
+    if(lineEmpty){
+        return;
+    }
+
+    //the rest of the text goes on the last line, cut to fit. Nothing past the word that overflowed can fit.
+    if(maxLines > 0 && (cut || lineWidth > availableWidth)) {
+        uint32_t runEnd = cut ? words[cutWord].offset + words[cutWord].length : lineEnd;
+        TextSpan kept = truncateRun(data, lineStart, runEnd, font, availableWidth, measurementContext, layoutContext);
+        kept.offset += textElement->textSpan.offset;
+        wrappedSpans.push_back(kept);
+        textElement->truncated = true;
+        textElement->truncatedSpan = kept;
+        return;
+    }
+    wrappedSpans.push_back({textElement->textSpan.offset + lineStart, lineEnd - lineStart});
+}
+
+//wraps one text element to its computed width
+template<typename Coord>
+void computeTextWrappingNode(BasicText<Coord>* textElement, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
+
+    //Grab the text data
+    std::string& text = textElement->text;
+    uint8_t font = textElement->font;
+    Coord width = textElement->layout.width;
+    const BasicStyle<Coord>* style = getStyle<Coord>(textElement->style);
+    Coord pl = style->paddingLeft; 
+    Coord pr = style->paddingRight;
+    Coord bw = style->borderWidth;
+    Coord availableWidth = width - pl - pr - bw - bw; 
+    size_t maxLines = style->overflow == OverflowHide ? textElement->maxLines : 0;
+    textElement->truncated = false;
+
+    if(textElement->textBuffer != nullptr) {
+        wrapTextSpans(textElement, availableWidth, maxLines, measurementContext, layoutContext);
+        textElement->measured = false;
+        return;
+    }
+
+    //Compute the wrapped lines for the text in the accessible width. 
+    //Lines are written over the existing strings so a rewrap of the same text reuses their storage.
+    std::vector<std::string>& wrappedText = textElement->wrappedText;
+    size_t lineCount = 0;
     
-    if(layoutDirection == LayoutColumn) {
-        for(int i = 0; i < childCount; i++) {
-            BaseElement* child = parent->children[i];
-            child->layout.y = y + pt + btw + currentVOffset;
-            currentVOffset += child->layout.height + gap; 
+    std::vector<TextSpan>& words = layoutContext->words;
+    splitStringByWhitesp(text, words);
+    std::string& currentLine = layoutContext->currentLine;
+    std::string& testLine = layoutContext->testLine;
+    currentLine.clear();
+    Coord currentLineWidth = 0;
+    size_t currentLineFirstWord = 0;
+    bool cut = false;
+    size_t cutWord = 0;
+
+    for(size_t i = 0; i < words.size(); i++){
+        const char* word = text.data() + words[i].offset;
+        size_t wordLength = words[i].length;
+        
+        // Measure the width of the word (plus space if not first word)
+        testLine.assign(currentLine);
+        if(!currentLine.empty()) testLine.push_back(' ');
+        testLine.append(word, wordLength);
+        Coord testLineWidth = currentLine.empty() && textElement->measured ? textElement->wordAdvances[i] : 
+            measurementContext->measureTextWidth(testLine, font);
+        
+        // If adding this word exceeds available width and current line is not empty
+        if(testLineWidth > availableWidth && !currentLine.empty()){
+            // On the last line allowed the rest of the text is cut instead
+            if(lineCount + 1 == maxLines) {
+                cut = true;
+                cutWord = i;
+                break;
+            }
+
+            // Store the current line
+            if(lineCount < wrappedText.size()) wrappedText[lineCount].assign(currentLine);
+            else wrappedText.push_back(currentLine);
+            lineCount++;
+            
+            // Start new line with current word
+            currentLine.assign(word, wordLength);
+            currentLineFirstWord = i;
+            currentLineWidth = textElement->measured ? textElement->wordAdvances[i] : measurementContext->measureTextWidth(currentLine, font);
+        } else {
+            // Add word to current line, swapping keeps both buffers alive
+            if(currentLine.empty()) currentLineFirstWord = i;
+            currentLine.swap(testLine);
+            currentLineWidth = testLineWidth;
         }
     }
-    else {
-        for(int i = 0; i < childCount; i++) {
-            BaseElement* child = parent->children[i];
-            child->layout.y = y + pt + btw;
+    
+    // Put the rest of the text on the last line, cut to fit with an ellipsis. The line is joined with single spaces like
+    // the ones above, up to the word that overflowed since nothing past it can fit.
+    if(maxLines > 0 && !currentLine.empty() && (cut || currentLineWidth > availableWidth)){
+        testLine.assign(currentLine);
+        if(cut) {
+            testLine.push_back(' ');
+            testLine.append(text, words[cutWord].offset, words[cutWord].length);
+        }
+        TextSpan kept = truncateRun(testLine.data(), 0, (uint32_t)testLine.size(), font, availableWidth, measurementContext, layoutContext);
+        currentLine.assign(testLine, 0, kept.length);
+        currentLine.append(Ellipsis, EllipsisLength);
+
+        //the span in the text is from the line's first word to where the cut falls in the words
+        size_t lastWord = cut ? cutWord : words.size() - 1;
+        uint32_t lineStart = words[currentLineFirstWord].offset;
+        uint32_t keptEnd = lineStart;
+        uint32_t joined = 0;
+        for(size_t i = currentLineFirstWord; i <= lastWord && joined < kept.length; i++) {
+            keptEnd = words[i].offset + (std::min)(words[i].length, kept.length - joined);
+            joined += words[i].length + 1;
+        }
+        textElement->truncated = true;
+        textElement->truncatedSpan = {lineStart, keptEnd - lineStart};
+    }
 
-            if(parentAlignItems == AlignCenter && !child->alignSelf || child->alignSelf == AlignCenter){
-                child->layout.y += (height - pt - btw - pb - bbw - child->layout.height) / 2;
+    // Add the last line if it's not empty
+    if(!currentLine.empty()){
+        if(lineCount < wrappedText.size()) wrappedText[lineCount].assign(currentLine);
+        else wrappedText.push_back(currentLine);
+        lineCount++;
+    }
+
+    wrappedText.resize(lineCount);
+
+    //the prepass results are only good for one layout, the text may change before the next
+    textElement->measured = false;
+}
+
+template<typename Coord>
+void computeTextWrapping(BasicBaseElement<Coord>* element, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
+    
+    if(element->elementType == ElementTypeText){
+        computeTextWrappingNode((BasicText<Coord>*)element, measurementContext, layoutContext);
+    }
+
+    //recur on children if this element is a container
+    if(isContainerType(element->elementType)){
+        BasicContainer<Coord>* container = (BasicContainer<Coord>*)element;
+        for(int i = 0; i < container->children.size(); i++){
+            computeTextWrapping(container->children[i], measurementContext, layoutContext);
+        }
+    }
+}
+
+//
+//Sixth pass, Position elements
+//
+
+//Places the grid's cells from the resolved tracks
+template<typename Coord>
+void computeGridPositions(BasicGrid<Coord>* grid){
+
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
+
+    const BasicStyle<Coord>* style = getStyle<Coord>(grid->style);
+    Accum left = (Accum)grid->layout.x + style->paddingLeft + style->borderWidth;
+    Accum top = (Accum)grid->layout.y + style->paddingTop + style->borderWidth;
+    Alignment gridAlignItems = style->alignItems;
+    Coord gap = style->gap;
+
+    std::vector<BasicBaseElement<Coord>*>& cells = grid->children;
+    int cellCount = cells.size();
+    int columnCount = grid->columnCount > 0 ? grid->columnCount : 1;
+
+    Accum rowOffset = 0;
+    for(int row = 0; row * columnCount < cellCount; row++) {
+        Coord rowHeight = grid->rowHeights[row];
+        Accum columnOffset = 0;
+
+        for(int column = 0; column < columnCount && row * columnCount + column < cellCount; column++) {
+            BasicBaseElement<Coord>* cell = cells[row * columnCount + column];
+            Coord columnWidth = grid->columnWidths[column];
+
+            Accum cellX = left + columnOffset;
+            Accum cellY = top + rowOffset;
+
+            //cells smaller than their track are aligned inside it
+            Alignment cellAlignSelf = getStyle<Coord>(cell->style)->alignSelf;
+            if((gridAlignItems == AlignCenter && !cellAlignSelf) || cellAlignSelf == AlignCenter){
+                cellX += (columnWidth - cell->layout.width) / 2;
+                cellY += (rowHeight - cell->layout.height) / 2;
             }
-            else if(parentAlignItems == AlignEnd && !child->alignSelf || child->alignSelf == AlignEnd){
-                child->layout.y += (height - pt - btw - pb - bbw - child->layout.height);
+            else if((gridAlignItems == AlignEnd && !cellAlignSelf) || cellAlignSelf == AlignEnd){
+                cellX += columnWidth - cell->layout.width;
+                cellY += rowHeight - cell->layout.height;
             }
+
+            cell->layout.x = toCoord<Coord>(cellX);
+            cell->layout.y = toCoord<Coord>(cellY);
+            columnOffset += (Accum)columnWidth + gap;
         }
+
+        rowOffset += (Accum)rowHeight + gap;
     }
+}
 
-    //recur on children
-    childCount = parent->children.size();
-    for(int i = 0; i < childCount; i++) {
-        BaseElement* child = parent->children[i];
-        if(child->elementType == ElementTypeContainer) {
-            Container* childAsContainer = (Container*)child;
-            computePositions(childAsContainer);
-        }
+//Rounds to the coordinate type, integer coordinates round to the nearest value
+template<typename Coord>
+Coord roundToCoord(double value) {
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
+    if(std::numeric_limits<Coord>::is_integer) {
+        value = std::floor(value + 0.5);
+        if(value > std::numeric_limits<Coord>::max()) return std::numeric_limits<Coord>::max();
+        if(value < std::numeric_limits<Coord>::lowest()) return std::numeric_limits<Coord>::lowest();
     }
+    return toCoord<Coord>((Accum)value);
 }
 
-//This is the main function that does the layout stuff
-void layout(Container* container, BaseMeasurementContext* measurementContext) {
-    initElements(container);
-    computeWidthFitSizing(container, measurementContext);
-    computeWidthsGrowSizing(container);
-    computeTextWrapping(container, measurementContext);
-    computeHeightFitSizing(container, measurementContext);
-    computeHeightsGrowSizing(container);
-    computePositions(container);
+//true if p is inside or on the triangle abc
+inline bool pointInTriangle(double px, double py, double ax, double ay, double bx, double by, double cx, double cy) {
+    double d1 = (px - bx) * (ay - by) - (ax - bx) * (py - by);
+    double d2 = (px - cx) * (by - cy) - (bx - cx) * (py - cy);
+    double d3 = (px - ax) * (cy - ay) - (cx - ax) * (py - ay);
+    bool hasNegative = d1 < 0 || d2 < 0 || d3 < 0;
+    bool hasPositive = d1 > 0 || d2 > 0 || d3 > 0;
+    return !(hasNegative && hasPositive);
+}
+
+//Ear clipping triangulation of a simple polygon. It is quadratic in the point count but only runs when the polygon 
+//changes. When no ear can be found, like for self intersecting points, what is left is covered with a fan.
+template<typename Coord>
+void triangulatePolygon(const std::vector<Coord>& points, std::vector<uint32_t>& triangles, std::vector<uint32_t>& remaining){
+
+    triangles.clear();
+    uint32_t pointCount = points.size() / 2;
+    if(pointCount < 3) {
+        return;
+    }
+
+    remaining.resize(pointCount);
+    double area = 0;
+    for(uint32_t i = 0; i < pointCount; i++) {
+        remaining[i] = i;
+        uint32_t next = (i + 1) % pointCount;
+        area += (double)points[i * 2] * points[next * 2 + 1] - (double)points[next * 2] * points[i * 2 + 1];
+    }
+
+    //an ear turns the same way as the whole polygon and has no other point inside it
+    double orientation = area < 0 ? -1 : 1;
+    size_t current = 0;
+    size_t misses = 0;
+    while(remaining.size() > 3 && misses < remaining.size()) {
+        size_t count = remaining.size();
+        current %= count;
+        uint32_t a = remaining[(current + count - 1) % count];
+        uint32_t b = remaining[current];
+        uint32_t c = remaining[(current + 1) % count];
+        double ax = points[a * 2], ay = points[a * 2 + 1];
+        double bx = points[b * 2], by = points[b * 2 + 1];
+        double cx = points[c * 2], cy = points[c * 2 + 1];
+
+        bool ear = ((bx - ax) * (cy - by) - (by - ay) * (cx - bx)) * orientation > 0;
+        for(size_t i = 0; i < count && ear; i++) {
+            uint32_t p = remaining[i];
+            if(p != a && p != b && p != c && pointInTriangle(points[p * 2], points[p * 2 + 1], ax, ay, bx, by, cx, cy)) {
+                ear = false;
+            }
+        }
+
+        if(ear) {
+            triangles.push_back(a);
+            triangles.push_back(b);
+            triangles.push_back(c);
+            remaining.erase(remaining.begin() + current);
+            current = current > 0 ? current - 1 : 0;
+            misses = 0;
+        }
+        else {
+            current++;
+            misses++;
+        }
+    }
+
+    for(size_t i = 1; i + 1 < remaining.size(); i++) {
+        triangles.push_back(remaining[0]);
+        triangles.push_back(remaining[i]);
+        triangles.push_back(remaining[i + 1]);
+    }
 }
 
+//Triangle strip around the closed outline, width wide and centered on the edges. Corners are mitered, sharp corners 
+//are limited to twice the width.
+template<typename Coord>
+void strokePolygon(const std::vector<Coord>& points, Coord width, std::vector<Coord>& outline){
+
+    outline.clear();
+    uint32_t pointCount = points.size() / 2;
+    if(pointCount < 2) {
+        return;
+    }
+
+    double half = width / 2.0;
+    for(uint32_t i = 0; i <= pointCount; i++) {
+        uint32_t point = i % pointCount;
+        uint32_t previous = (point + pointCount - 1) % pointCount;
+        uint32_t next = (point + 1) % pointCount;
+        double x = points[point * 2];
+        double y = points[point * 2 + 1];
+
+        //unit normals of the edges before and after the point, 0 for edges of no length
+        double normals[4] = {};
+        double edges[4] = {x - points[previous * 2], y - points[previous * 2 + 1], points[next * 2] - x, points[next * 2 + 1] - y};
+        for(int edge = 0; edge < 2; edge++) {
+            double length = std::sqrt(edges[edge * 2] * edges[edge * 2] + edges[edge * 2 + 1] * edges[edge * 2 + 1]);
+            if(length > 0) {
+                normals[edge * 2] = -edges[edge * 2 + 1] / length;
+                normals[edge * 2 + 1] = edges[edge * 2] / length;
+            }
+        }
+
+        double miterX = normals[0] + normals[2];
+        double miterY = normals[1] + normals[3];
+        double miterLength = std::sqrt(miterX * miterX + miterY * miterY);
+        double scale = 0;
+        if(miterLength > 1e-9) {
+            miterX /= miterLength;
+            miterY /= miterLength;
+            const double* edgeNormal = normals[2] != 0 || normals[3] != 0 ? normals + 2 : normals;
+            scale = half / (std::max)(miterX * edgeNormal[0] + miterY * edgeNormal[1], 0.25);
+        }
+
+        outline.push_back(roundToCoord<Coord>(x + miterX * scale));
+        outline.push_back(roundToCoord<Coord>(y + miterY * scale));
+        outline.push_back(roundToCoord<Coord>(x - miterX * scale));
+        outline.push_back(roundToCoord<Coord>(y - miterY * scale));
+    }
+}
+
+//Moves x, y pairs by dx, dy
+template<typename Coord>
+void shiftPoints(std::vector<Coord>& points, typename CoordTraits<Coord>::Accumulator dx, typename CoordTraits<Coord>::Accumulator dy){
+    for(size_t i = 0; i + 1 < points.size(); i += 2) {
+        points[i] = toCoord<Coord>(points[i] + dx);
+        points[i + 1] = toCoord<Coord>(points[i + 1] + dy);
+    }
+}
+
+//Scales the points into the polygon's content box and builds the fill and stroke, unless nothing they depend on 
+//changed. The geometry is built at the box's origin and then moved there, so a box that only moved is shifted again 
+//instead of being built again.
+template<typename Coord>
+void updatePolygonGeometry(BasicPolygon<Coord>* polygon, LayoutContext* layoutContext){
+
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
+
+    const BasicStyle<Coord>* style = getStyle<Coord>(polygon->style);
+    Coord box[4] = {
+        toCoord<Coord>((Accum)polygon->layout.x + style->paddingLeft + style->borderWidth),
+        toCoord<Coord>((Accum)polygon->layout.y + style->paddingTop + style->borderWidth),
+        toCoord<Coord>((std::max)((Accum)polygon->layout.width - style->paddingLeft - style->paddingRight - 2 * (Accum)style->borderWidth, (Accum)0)),
+        toCoord<Coord>((std::max)((Accum)polygon->layout.height - style->paddingTop - style->paddingBottom - 2 * (Accum)style->borderWidth, (Accum)0))
+    };
+    Coord strokeWidth = polygon->stroke ? (std::max)(style->borderWidth, (Coord)1) : 0;
+
+    if(polygon->geometryValid && polygon->geometryFill == polygon->fill && polygon->geometryStrokeWidth == strokeWidth &&
+        polygon->geometryBox[2] == box[2] && polygon->geometryBox[3] == box[3] && polygon->geometryPoints == polygon->points) {
+        if(polygon->geometryBox[0] != box[0] || polygon->geometryBox[1] != box[1]) {
+            Accum dx = (Accum)box[0] - polygon->geometryBox[0];
+            Accum dy = (Accum)box[1] - polygon->geometryBox[1];
+            shiftPoints(polygon->boxPoints, dx, dy);
+            shiftPoints(polygon->strokeOutline, dx, dy);
+            polygon->geometryBox[0] = box[0];
+            polygon->geometryBox[1] = box[1];
+        }
+        return;
+    }
+
+    polygon->geometryPoints = polygon->points;
+    for(int i = 0; i < 4; i++) {
+        polygon->geometryBox[i] = box[i];
+    }
+    polygon->geometryStrokeWidth = strokeWidth;
+    polygon->geometryFill = polygon->fill;
+    polygon->geometryValid = true;
+
+    //the bounds are stretched over the box, a flat side is only moved
+    std::vector<Coord>& points = polygon->points;
+    std::vector<Coord>& boxPoints = polygon->boxPoints;
+    boxPoints.resize(points.size());
+    Coord* bounds = polygon->bounds;
+    for(int axis = 0; axis < 2; axis++) {
+        double extent = (double)bounds[axis + 2] - bounds[axis];
+        double scale = extent > 0 ? box[axis + 2] / extent : 1;
+        for(size_t i = axis; i < points.size(); i += 2) {
+            boxPoints[i] = roundToCoord<Coord>((points[i] - bounds[axis]) * scale);
+        }
+    }
+
+    if(polygon->fill) {
+        triangulatePolygon(boxPoints, polygon->fillTriangles, layoutContext->polygonIndices);
+    }
+    else {
+        polygon->fillTriangles.clear();
+    }
+
+    if(strokeWidth > 0) {
+        strokePolygon(boxPoints, strokeWidth, polygon->strokeOutline);
+    }
+    else {
+        polygon->strokeOutline.clear();
+    }
+
+    shiftPoints(boxPoints, (Accum)box[0], (Accum)box[1]);
+    shiftPoints(polygon->strokeOutline, (Accum)box[0], (Accum)box[1]);
+}
+
+//builds the geometry of the polygons among a container's children, from firstChild on
+template<typename Coord>
+void updateChildPolygons(BasicContainer<Coord>* parent, int firstChild, LayoutContext* layoutContext){
+    std::vector<BasicBaseElement<Coord>*>& children = parent->children;
+    for(int i = firstChild; i < children.size(); i++) {
+        if(children[i]->elementType == ElementTypePolygon) {
+            updatePolygonGeometry((BasicPolygon<Coord>*)children[i], layoutContext);
+        }
+    }
+}
+
+//places the children of one container inside it, from firstChild on. The children before it must already be placed.
+template<typename Coord>
+void computePositionsNode(BasicContainer<Coord>* parent, LayoutContext* layoutContext, int firstChild = 0){
+
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
+
+    //grids place their cells from the tracks
+    if(parent->elementType == ElementTypeGrid) {
+        computeGridPositions((BasicGrid<Coord>*)parent);
+        updateChildPolygons(parent, 0, layoutContext);
+        return;
+    }
+
+    //grab the paraents layout directions 
+    const BasicStyle<Coord>* style = getStyle<Coord>(parent->style);
+    LayoutDirection layoutDirection = style->layoutDirection;
+
+    //grab parent data 
+    Coord pl = style->paddingLeft;
+    Coord pr = style->paddingRight;
+    Coord blw = style->borderWidth;
+    Coord brw = style->borderWidth;
+    Coord x = parent->layout.x;
+    Coord width = parent->layout.width;
+
+    Coord pt = style->paddingTop;
+    Coord pb = style->paddingBottom;
+    Coord btw = style->borderWidth;
+    Coord bbw = style->borderWidth;
+    Coord y = parent->layout.y;
+    Coord height = parent->layout.height;
+
+    Alignment parentAlignItems = style->alignItems;
+    
+    Coord gap = style->gap;
+
+    int childCount = parent->children.size();
+
+    //position elements horizontally, carrying on after the previous child when starting in the middle
+    Accum currentHOffset = 0;
+    
+    if(layoutDirection == LayoutRow) {
+        if(firstChild > 0) {
+            BasicBaseElement<Coord>* previous = parent->children[firstChild - 1];
+            currentHOffset = (Accum)previous->layout.x + previous->layout.width + gap - x - pl - blw;
+        }
+        for(int i = firstChild; i < childCount; i++) {
+            BasicBaseElement<Coord>* child = parent->children[i];
+            child->layout.x = toCoord<Coord>(x + pl + blw + currentHOffset);
+            currentHOffset += child->layout.width + gap; 
+        }
+    }
+    else {
+        for(int i = firstChild; i < childCount; i++) {
+            BasicBaseElement<Coord>* child = parent->children[i];
+            child->layout.x = x + pl + blw;
+
+            Alignment childAlignSelf = getStyle<Coord>(child->style)->alignSelf;
+            if((parentAlignItems == AlignCenter && !childAlignSelf) || childAlignSelf == AlignCenter){
+                child->layout.x += (width - pl - blw - pr - brw - child->layout.width) / 2;
+            }
+            else if((parentAlignItems == AlignEnd && !childAlignSelf) || childAlignSelf == AlignEnd){
+                child->layout.x += (width - pl - blw - pr - brw - child->layout.width);
+            }
+        }
+    }
+
+    //position elements vertically
+    Accum currentVOffset = 0;
+    
+    if(layoutDirection == LayoutColumn) {
+        if(firstChild > 0) {
+            BasicBaseElement<Coord>* previous = parent->children[firstChild - 1];
+            currentVOffset = (Accum)previous->layout.y + previous->layout.height + gap - y - pt - btw;
+        }
+        for(int i = firstChild; i < childCount; i++) {
+            BasicBaseElement<Coord>* child = parent->children[i];
+            child->layout.y = toCoord<Coord>(y + pt + btw + currentVOffset);
+            currentVOffset += child->layout.height + gap; 
+        }
+    }
+    else {
+        for(int i = firstChild; i < childCount; i++) {
+            BasicBaseElement<Coord>* child = parent->children[i];
+            child->layout.y = y + pt + btw;
+
+            Alignment childAlignSelf = getStyle<Coord>(child->style)->alignSelf;
+            if((parentAlignItems == AlignCenter && !childAlignSelf) || childAlignSelf == AlignCenter){
+                child->layout.y += (height - pt - btw - pb - bbw - child->layout.height) / 2;
+            }
+            else if((parentAlignItems == AlignEnd && !childAlignSelf) || childAlignSelf == AlignEnd){
+                child->layout.y += (height - pt - btw - pb - bbw - child->layout.height);
+            }
+        }
+    }
+
+    //the polygons now have their box
+    updateChildPolygons(parent, firstChild, layoutContext);
+}
+
+template<typename Coord>
+void computePositions(BasicContainer<Coord>* parent, LayoutContext* layoutContext){
+
+    computePositionsNode(parent, layoutContext);
+
+    //recur on children
+    int childCount = parent->children.size();
+    for(int i = 0; i < childCount; i++) {
+        BasicBaseElement<Coord>* child = parent->children[i];
+        if(isContainerType(child->elementType)) {
+            BasicContainer<Coord>* childAsContainer = (BasicContainer<Coord>*)child;
+            computePositions(childAsContainer, layoutContext);
+        }
+    }
+}
+
+//Moves an element and everything under it down by offset, for boxes that keep their size and only change place
+template<typename Coord>
+void offsetElement(BasicBaseElement<Coord>* element, typename CoordTraits<Coord>::Accumulator offset, LayoutContext* layoutContext){
+    element->layout.y = toCoord<Coord>(element->layout.y + offset);
+
+    if(isContainerType(element->elementType)) {
+        BasicContainer<Coord>* container = (BasicContainer<Coord>*)element;
+        for(size_t i = 0; i < container->children.size(); i++) {
+            offsetElement(container->children[i], offset, layoutContext);
+        }
+    }
+    else if(element->elementType == ElementTypePolygon) {
+        updatePolygonGeometry((BasicPolygon<Coord>*)element, layoutContext);
+    }
+}
+
+//This is the main function that does the layout stuff
+template<typename Coord>
+void layout(BasicContainer<Coord>* container, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext) {
+    initElements(container, (BasicContainer<Coord>*)nullptr);
+    computeFitSizing<Coord, AxisX<Coord>>(container, measurementContext, layoutContext);
+    computeGrowSizing<Coord, AxisX<Coord>>(container, measurementContext, layoutContext);
+    computeTextWrapping(container, measurementContext, layoutContext);
+    computeFitSizing<Coord, AxisY<Coord>>(container, measurementContext, layoutContext);
+    computeGrowSizing<Coord, AxisY<Coord>>(container, measurementContext, layoutContext);
+    computePositions(container, layoutContext);
+}
+
+template<typename Coord>
+void layout(BasicContainer<Coord>* container, BasicMeasurementContext<Coord>* measurementContext) {
+    LayoutContext layoutContext;
+    layout(container, measurementContext, &layoutContext);
+}
+
+template<typename Coord>
+void layoutProfiled(BasicContainer<Coord>* container, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext, 
+    double passSeconds[LayoutPassCount]) {
+
+    std::chrono::steady_clock::time_point passStart = std::chrono::steady_clock::now();
+    int pass = 0;
+
+    //adds the time since the last pass ended to this pass
+    auto endPass = [&]() {
+        std::chrono::steady_clock::time_point passEnd = std::chrono::steady_clock::now();
+        passSeconds[pass++] += std::chrono::duration<double>(passEnd - passStart).count();
+        passStart = passEnd;
+    };
+
+    initElements(container, (BasicContainer<Coord>*)nullptr);
+    endPass();
+    computeFitSizing<Coord, AxisX<Coord>>(container, measurementContext, layoutContext);
+    endPass();
+    computeGrowSizing<Coord, AxisX<Coord>>(container, measurementContext, layoutContext);
+    endPass();
+    computeTextWrapping(container, measurementContext, layoutContext);
+    endPass();
+    computeFitSizing<Coord, AxisY<Coord>>(container, measurementContext, layoutContext);
+    endPass();
+    computeGrowSizing<Coord, AxisY<Coord>>(container, measurementContext, layoutContext);
+    endPass();
+    computePositions(container, layoutContext);
+    endPass();
+}
+
+
+//
+//Append only layout. Children added at the end of a column whose width doesn't change and whose height follows its 
+//content leave every other child where it was, so only the new children are layed out and the height change is 
+//carried up the chain of parents. Siblings along that chain are only touched when their own size or place changes.
+//
+
+//grows the heights of a subtree again after its height changed, the fit heights from the last layout are still good
+template<typename Coord>
+void regrowHeights(BasicContainer<Coord>* container, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
+
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
+
+    //growing overwrote the sizes and the grid rows, start again from the fit
+    std::vector<BasicBaseElement<Coord>*>& children = container->children;
+    for(int i = 0; i < children.size(); i++) {
+        children[i]->layout.height = children[i]->layout.fitHeight;
+    }
+    if(container->elementType == ElementTypeGrid) {
+        Accum contentSize = 0;
+        Accum minContentSize = 0;
+        computeGridTracks<Coord, AxisY<Coord>>((BasicGrid<Coord>*)container, getStyle<Coord>(container->style), contentSize, minContentSize);
+    }
+
+    computeGrowSizingNode<Coord, AxisY<Coord>>(container, measurementContext, layoutContext);
+
+    for(int i = 0; i < children.size(); i++) {
+        if(isContainerType(children[i]->elementType)) {
+            regrowHeights((BasicContainer<Coord>*)children[i], measurementContext, layoutContext);
+        }
+    }
+}
+
+//Grows and places the children of one container on the chain of parents again, next is the child on the chain and is 
+//left to the caller. Returns false if next moved, then everything under it has to be placed again. A plain column
+//that was and still is exactly its content height doesn't grow anything, next only takes its new fit height and the 
+//children after it move down by the change.
+template<typename Coord>
+bool relayoutSpineNode(BasicContainer<Coord>* container, BasicBaseElement<Coord>* next, bool wasContentHeight, 
+    BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
+
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
+
+    std::vector<BasicBaseElement<Coord>*>& children = container->children;
+    int childCount = children.size();
+
+    if(wasContentHeight && container->elementType == ElementTypeContainer && container->height < 0 && 
+        container->layout.height == container->layout.fitHeight && getStyle<Coord>(container->style)->layoutDirection == LayoutColumn) {
+        next->layout.height = next->layout.fitHeight;
+
+        //the children after next are found from the back, in a log they are few
+        Accum below = (Accum)next->layout.y + next->layout.height + getStyle<Coord>(container->style)->gap;
+        int i = childCount - 1;
+        while(i >= 0 && children[i] != next) {
+            i--;
+        }
+        if(i + 1 < childCount) {
+            Accum offset = below - children[i + 1]->layout.y;
+            for(int j = i + 1; j < childCount && offset != 0; j++) {
+                offsetElement(children[j], offset, layoutContext);
+            }
+        }
+        return true;
+    }
+
+    //the sizes and places before, to find the siblings that have to follow
+    std::vector<BasicComputedLayout<Coord>>& previous = PreviousLayouts<Coord>::buffer(layoutContext);
+    previous.resize(childCount);
+    for(int i = 0; i < childCount; i++) {
+        previous[i] = children[i]->layout;
+        children[i]->layout.height = children[i]->layout.fitHeight;
+    }
+
+    computeGrowSizingNode<Coord, AxisY<Coord>>(container, measurementContext, layoutContext);
+    computePositionsNode(container, layoutContext);
+
+    bool nextInPlace = true;
+    for(int i = 0; i < childCount; i++) {
+        BasicBaseElement<Coord>* child = children[i];
+        bool moved = child->layout.x != previous[i].x || child->layout.y != previous[i].y;
+        if(child == next) {
+            nextInPlace = !moved;
+        }
+        else if(isContainerType(child->elementType)) {
+            bool resized = child->layout.height != previous[i].height;
+            if(resized) {
+                regrowHeights((BasicContainer<Coord>*)child, measurementContext, layoutContext);
+            }
+            if(resized || moved) {
+                computePositions((BasicContainer<Coord>*)child, layoutContext);
+            }
+        }
+    }
+    return nextInPlace;
+}
+
+//Runs relayoutSpineNode from top down to the parent of element, depth is how far element is below the appended column's
+//parent and contentHeights how many parents from there up were exactly their content height before. Returns false if 
+//something on the chain moved, everything under it has then been grown and placed again.
+template<typename Coord>
+bool relayoutSpine(BasicBaseElement<Coord>* element, BasicContainer<Coord>* top, int depth, int contentHeights, 
+    BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
+
+    BasicContainer<Coord>* parent = element->parent;
+    if(parent != top && !relayoutSpine(parent, top, depth + 1, contentHeights, measurementContext, layoutContext)) {
+        return false;
+    }
+
+    if(!relayoutSpineNode(parent, element, depth < contentHeights, measurementContext, layoutContext)) {
+        BasicContainer<Coord>* container = (BasicContainer<Coord>*)element;
+        regrowHeights(container, measurementContext, layoutContext);
+        computePositions(container, layoutContext);
+        return false;
+    }
+    return true;
+}
+
+template<typename Coord>
+bool layoutAppended(BasicContainer<Coord>* column, size_t firstNewChild, BasicMeasurementContext<Coord>* measurementContext, 
+    LayoutContext* layoutContext) {
+
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
+
+    std::vector<BasicBaseElement<Coord>*>& children = column->children;
+    size_t childCount = children.size();
+    if(firstNewChild >= childCount) {
+        return true;
+    }
+
+    const BasicStyle<Coord>* style = getStyle<Coord>(column->style);
+    Accum spaceX = AxisX<Coord>::leadingSpace(style) + AxisX<Coord>::trailingSpace(style);
+
+    //the column's height has to be exactly its content before and after, then no child of it grows or shrinks
+    bool fastPath = column->elementType == ElementTypeContainer && style->layoutDirection == LayoutColumn && 
+        column->height < 0 && column->layout.height == column->layout.fitHeight && 
+        column->layout.fitHeight != std::numeric_limits<Coord>::max();
+
+    //the new children have to fit in the column's width without changing it, else the whole tree changes
+    for(size_t i = firstNewChild; i < childCount && fastPath; i++) {
+        BasicBaseElement<Coord>* child = children[i];
+        initElements(child, column);
+        computeFitSizing<Coord, AxisX<Coord>>(child, measurementContext, layoutContext);
+        if(column->width < 0 && spaceX + child->layout.fitWidth > column->layout.fitWidth) {
+            fastPath = false;
+        }
+
+        //a min width nothing asked for last time isn't needed now either, one that was is kept up to date
+        else if(column->minWidth < 0 && column->layout.minWidth >= 0 && 
+            spaceX + resolveMinSize<Coord, AxisX<Coord>>(child, measurementContext, layoutContext) > column->layout.minWidth) {
+            fastPath = false;
+        }
+    }
+
+    //how much the fit and min heights of the last refit element changed
+    Accum fitChange = 0;
+    Accum minChange = 0;
+
+    if(fastPath) {
+
+        //size the new children inside the column's width like the grow pass would
+        Coord availableWidth = toCoord<Coord>(column->layout.width - spaceX);
+        stretchCrossAxis<Coord, AxisX<Coord>>(column, style, availableWidth, (int)firstNewChild);
+
+        Accum addedHeight = firstNewChild > 0 ? (Accum)(childCount - firstNewChild) * style->gap : (Accum)(childCount - 1) * style->gap;
+        Accum addedMinHeight = addedHeight;
+        for(size_t i = firstNewChild; i < childCount; i++) {
+            BasicBaseElement<Coord>* child = children[i];
+            if(isContainerType(child->elementType)) {
+                computeGrowSizing<Coord, AxisX<Coord>>((BasicContainer<Coord>*)child, measurementContext, layoutContext);
+            }
+            computeTextWrapping(child, measurementContext, layoutContext);
+            computeFitSizing<Coord, AxisY<Coord>>(child, measurementContext, layoutContext);
+            addedHeight += child->layout.fitHeight;
+            addedMinHeight += child->layout.minHeight;
+        }
+
+        Accum fitHeight = (Accum)column->layout.fitHeight + addedHeight;
+        fastPath = toCoord<Coord>(fitHeight) == fitHeight;
+        if(fastPath) {
+            column->layout.fitHeight = toCoord<Coord>(fitHeight);
+            column->layout.height = column->layout.fitHeight;
+            fitChange = addedHeight;
+            if(column->minHeight < 0) {
+                column->layout.minHeight = toCoord<Coord>(column->layout.minHeight + addedMinHeight);
+                minChange = addedMinHeight;
+            }
+        }
+    }
+
+    //refit the parents up to the first one whose fit doesn't change, the layout above it stays as it is. Parents that
+    //were exactly their content height are counted from the column up, they can skip growing their children. A plain 
+    //column sized by its content only adds the change of the child on the chain instead of adding up every child.
+    BasicContainer<Coord>* top = column;
+    int contentHeights = 0;
+    bool counting = true;
+    while(fastPath && top->parent != nullptr) {
+        BasicContainer<Coord>* parent = top->parent;
+        Coord fitHeight = parent->layout.fitHeight;
+        Coord minHeight = parent->layout.minHeight;
+        Coord height = parent->layout.height;
+        counting = counting && height == fitHeight;
+        contentHeights += counting ? 1 : 0;
+
+        Accum newFitHeight = (Accum)fitHeight + fitChange;
+        Accum newMinHeight = (Accum)minHeight + minChange;
+        if(parent->elementType == ElementTypeContainer && parent->height < 0 && parent->minHeight < 0 && 
+            getStyle<Coord>(parent->style)->layoutDirection == LayoutColumn && fitHeight != std::numeric_limits<Coord>::max() && 
+            minHeight != std::numeric_limits<Coord>::max() && toCoord<Coord>(newFitHeight) == newFitHeight && 
+            toCoord<Coord>(newMinHeight) == newMinHeight) {
+            parent->layout.fitHeight = toCoord<Coord>(newFitHeight);
+            parent->layout.height = parent->layout.fitHeight;
+            parent->layout.minHeight = toCoord<Coord>(newMinHeight);
+        }
+        else {
+            computeFitSizingNode<Coord, AxisY<Coord>>(parent, measurementContext, layoutContext);
+        }
+        fitChange = (Accum)parent->layout.fitHeight - fitHeight;
+        minChange = (Accum)parent->layout.minHeight - minHeight;
+
+        if(fitChange == 0 && minChange == 0) {
+            parent->layout.height = height;
+            top = parent;
+            break;
+        }
+        top = parent;
+    }
+
+    if(!fastPath) {
+        BasicContainer<Coord>* root = column;
+        while(root->parent != nullptr) {
+            root = root->parent;
+        }
+        layout(root, measurementContext, layoutContext);
+        return false;
+    }
+
+    //then grow and place down the chain again
+    if(top != column) {
+        if(!relayoutSpine(column, top, 0, contentHeights, measurementContext, layoutContext)) {
+            return false;
+        }
+
+        //the column was grown or shrunk, its children have to follow
+        if(column->layout.height != column->layout.fitHeight) {
+            regrowHeights(column, measurementContext, layoutContext);
+            computePositions(column, layoutContext);
+            return false;
+        }
+    }
+
+    //the column is its content height so only the new children are grown and placed, after the previous last child
+    for(size_t i = firstNewChild; i < childCount; i++) {
+        if(isContainerType(children[i]->elementType)) {
+            computeGrowSizing<Coord, AxisY<Coord>>((BasicContainer<Coord>*)children[i], measurementContext, layoutContext);
+        }
+    }
+    computePositionsNode(column, layoutContext, (int)firstNewChild);
+    for(size_t i = firstNewChild; i < childCount; i++) {
+        if(isContainerType(children[i]->elementType)) {
+            computePositions((BasicContainer<Coord>*)children[i], layoutContext);
+        }
+    }
+    return true;
+}
+
+template<typename Coord>
+Coord resolveMinWidth(BasicBaseElement<Coord>* element, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext) {
+    return resolveMinSize<Coord, AxisX<Coord>>(element, measurementContext, layoutContext);
+}
+
+//
+//Time sliced layout. The same passes as layout() run over a flattened copy of the tree, each one with a cursor so it 
+//can stop after any element. Fit passes go over the elements in reverse pre-order so children come before their 
+//parents, the others go in pre-order so parents come first.
+//
+
+enum LayoutJobPass : uint8_t {
+    JobPassFlatten, // Flattens the tree and resets the computed sizes
+    JobPassFitX,
+    JobPassGrowX,
+    JobPassWrap,
+    JobPassFitY,
+    JobPassGrowY,
+    JobPassPositions,
+    JobPassDone
+};
+
+const uint32_t LayoutJobTimeCheckInterval = 16; // Elements visited between clock reads
+
+template<typename Coord>
+BasicLayoutJob<Coord>::BasicLayoutJob(BasicContainer<Coord>* root, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext) {
+    this->root = root;
+    this->measurementContext = measurementContext;
+    this->layoutContext = layoutContext;
+    restart();
+}
+
+template<typename Coord>
+void BasicLayoutJob<Coord>::restart() {
+    elements.clear();
+    stack.clear();
+    pass = JobPassFlatten;
+    cursor = 0;
+    status = LayoutIncomplete;
+}
+
+template<typename Coord>
+void BasicLayoutJob<Coord>::restartFrom(LayoutPass pass) {
+    if(pass == LayoutPassInit || elements.empty()) {
+        restart();
+        return;
+    }
+    stack.clear();
+    this->pass = (uint8_t)pass;
+    cursor = 0;
+    status = LayoutIncomplete;
+}
+
+template<typename Coord>
+void BasicLayoutJob<Coord>::cancel() {
+    stack.clear();
+    pass = JobPassDone;
+    status = LayoutCancelled;
+}
+
+//Does the work for one element, returns false once every pass is done
+template<typename Coord>
+bool BasicLayoutJob<Coord>::step() {
+
+    size_t elementCount = elements.size();
+
+    while(pass != JobPassDone) {
+        switch(pass) {
+            case JobPassFlatten: {
+                BasicBaseElement<Coord>* element = nullptr;
+                BasicContainer<Coord>* parent = nullptr;
+                if(elements.empty()) {
+                    element = root;
+                }
+                else {
+                    //walk down the explicit stack, finished containers are popped without counting as work
+                    while(!stack.empty() && element == nullptr) {
+                        Frame& frame = stack.back();
+                        if(frame.nextChild < frame.container->children.size()) {
+                            element = frame.container->children[frame.nextChild++];
+                            parent = frame.container;
+                        }
+                        else {
+                            stack.pop_back();
+                        }
+                    }
+                }
+
+                if(element == nullptr) {
+                    break;
+                }
+
+                element->layout.width = 0;
+                element->layout.height = 0;
+                element->parent = parent;
+                elements.push_back(element);
+                if(isContainerType(element->elementType)) {
+                    stack.push_back(Frame{(BasicContainer<Coord>*)element, 0});
+                }
+                return true;
+            }
+
+            case JobPassFitX:
+            case JobPassFitY:
+                if(cursor < elementCount) {
+                    BasicBaseElement<Coord>* element = elements[elementCount - 1 - cursor++];
+                    if(pass == JobPassFitX) {
+                        computeFitSizingNode<Coord, AxisX<Coord>>(element, measurementContext, layoutContext);
+                    }
+                    else {
+                        computeFitSizingNode<Coord, AxisY<Coord>>(element, measurementContext, layoutContext);
+                    }
+                    return true;
+                }
+                break;
+
+            case JobPassGrowX:
+            case JobPassGrowY:
+                if(cursor < elementCount) {
+                    BasicBaseElement<Coord>* element = elements[cursor++];
+                    if(isContainerType(element->elementType)) {
+                        if(pass == JobPassGrowX) {
+                            computeGrowSizingNode<Coord, AxisX<Coord>>((BasicContainer<Coord>*)element, measurementContext, layoutContext);
+                        }
+                        else {
+                            computeGrowSizingNode<Coord, AxisY<Coord>>((BasicContainer<Coord>*)element, measurementContext, layoutContext);
+                        }
+                    }
+                    return true;
+                }
+                break;
+
+            case JobPassWrap:
+                if(cursor < elementCount) {
+                    BasicBaseElement<Coord>* element = elements[cursor++];
+                    if(element->elementType == ElementTypeText) {
+                        computeTextWrappingNode((BasicText<Coord>*)element, measurementContext, layoutContext);
+                    }
+                    return true;
+                }
+                break;
+
+            case JobPassPositions:
+                if(cursor < elementCount) {
+                    BasicBaseElement<Coord>* element = elements[cursor++];
+                    if(isContainerType(element->elementType)) {
+                        computePositionsNode((BasicContainer<Coord>*)element, layoutContext);
+                    }
+                    return true;
+                }
+                break;
+        }
+
+        //the current pass is finished, move the cursor to the next one
+        pass++;
+        cursor = 0;
+    }
+
+    status = LayoutComplete;
+    return false;
+}
+
+template<typename Coord>
+LayoutStatus BasicLayoutJob<Coord>::run(uint32_t workBudget, uint32_t timeBudgetMicroseconds) {
+
+    if(status != LayoutIncomplete) {
+        return status;
+    }
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeBudgetMicroseconds);
+    uint32_t work = 0;
+
+    while(step()) {
+        work++;
+        if(workBudget > 0 && work >= workBudget) {
+            break;
+        }
+        if(timeBudgetMicroseconds > 0 && work % LayoutJobTimeCheckInterval == 0 && std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+    }
+
+    return status;
+}
+
+
+//
+//Async layout. Each round runs a layout job against the cache, misses are queued as requests and answered with an 
+//estimate so the round can finish. The next round picks the job up at the first pass that had to estimate, the 
+//passes before it only got real answers and their results are kept.
+//
+
+template<typename Coord>
+BasicAsyncLayout<Coord>::BasicAsyncLayout(BasicContainer<Coord>* root, LayoutContext* layoutContext): job(root, this, layoutContext) {
+    this->root = root;
+    this->layoutContext = layoutContext;
+    resumePass = LayoutPassInit;
+    missedPass = LayoutPassCount;
+}
+
+template<typename Coord>
+LayoutStatus BasicAsyncLayout<Coord>::run() {
+    pendingRequests.clear();
+    pendingWidths.clear();
+    pendingLineHeights.clear();
+    missedPass = LayoutPassCount;
+
+    job.restartFrom(resumePass);
+    job.run(0, 0);
+
+    if(pendingRequests.empty()) {
+        resumePass = LayoutPassInit;
+        return LayoutComplete;
+    }
+
+    //an estimate in a grow pass changed the sizes its fit pass set, so that fit pass runs again as well
+    if(missedPass == LayoutPassGrowWidth) resumePass = LayoutPassFitWidth;
+    else if(missedPass == LayoutPassGrowHeight) resumePass = LayoutPassFitHeight;
+    else resumePass = missedPass;
+    return LayoutWaiting;
+}
+
+template<typename Coord>
+void BasicAsyncLayout<Coord>::resolveRequest(size_t index, Coord result) {
+    MeasurementRequest& request = pendingRequests[index];
+    if(request.isLineHeight) {
+        lineHeights[((uint32_t)(uint16_t)request.lineSpacing << 8) | request.font] = result;
+    }
+    else {
+        key.assign(1, (char)request.font);
+        key += request.text;
+        textWidths[key] = result;
+    }
+}
+
+template<typename Coord>
+void BasicAsyncLayout<Coord>::resolveWith(BasicMeasurementContext<Coord>* measurementContext) {
+    for(size_t i = 0; i < pendingRequests.size(); i++) {
+        MeasurementRequest& request = pendingRequests[i];
+        if(request.isLineHeight) {
+            resolveRequest(i, measurementContext->getLineHeight(request.lineSpacing, request.font));
+        }
+        else {
+            resolveRequest(i, measurementContext->measureTextWidth(request.text, request.font));
+        }
+    }
+}
+
+template<typename Coord>
+void BasicAsyncLayout<Coord>::clearCache() {
+    textWidths.clear();
+    lineHeights.clear();
+}
+
+//Looks up a width, a miss is queued once per round
+template<typename Coord>
+bool BasicAsyncLayout<Coord>::lookupWidth(const char* str, size_t length, uint8_t font, Coord& width) {
+    key.assign(1, (char)font);
+    key.append(str, length);
+
+    typename std::unordered_map<std::string, Coord>::iterator found = textWidths.find(key);
+    if(found != textWidths.end()) {
+        width = found->second;
+        return true;
+    }
+
+    if(missedPass == LayoutPassCount) missedPass = job.getPass();
+    if(pendingWidths.find(key) == pendingWidths.end()) {
+        pendingWidths[key] = (uint32_t)pendingRequests.size();
+        pendingRequests.push_back(MeasurementRequest{std::string(str, length), font, 0, false});
+    }
+    return false;
+}
+
+template<typename Coord>
+Coord BasicAsyncLayout<Coord>::measureTextWidth(std::string& str, uint8_t font) {
+
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
+
+    Coord width = 0;
+    if(lookupWidth(str.data(), str.size(), font, width)) {
+        return width;
+    }
+
+    //estimate the width from the words and the spaces between them, the ones not known yet count as 0
+    Accum estimate = 0;
+    size_t i = 0;
+    while(i < str.size()) {
+        size_t start = i;
+        if(isSpace(str[i])) {
+            i++;
+        }
+        else {
+            while(i < str.size() && !isSpace(str[i])) {
+                i++;
+            }
+            if(start == 0 && i == str.size()) {
+                break; //a single word is the request itself
+            }
+        }
+
+        Coord partWidth = 0;
+        if(lookupWidth(str.data() + start, i - start, font, partWidth)) {
+            estimate += partWidth;
+        }
+    }
+
+    return toCoord<Coord>(estimate);
+}
+
+template<typename Coord>
+Coord BasicAsyncLayout<Coord>::getLineHeight(int16_t lineSpacing, uint8_t font) {
+    uint32_t lineHeightKey = ((uint32_t)(uint16_t)lineSpacing << 8) | font;
+
+    typename std::unordered_map<uint32_t, Coord>::iterator found = lineHeights.find(lineHeightKey);
+    if(found != lineHeights.end()) {
+        return found->second;
+    }
+
+    if(missedPass == LayoutPassCount) missedPass = job.getPass();
+    if(pendingLineHeights.find(lineHeightKey) == pendingLineHeights.end()) {
+        pendingLineHeights[lineHeightKey] = (uint32_t)pendingRequests.size();
+        pendingRequests.push_back(MeasurementRequest{std::string(), font, lineSpacing, true});
+    }
+
+    //estimate from the tallest font known with the same spacing, so the boxes keep a sensible height meanwhile
+    Coord estimate = 0;
+    for(found = lineHeights.begin(); found != lineHeights.end(); found++) {
+        if((found->first >> 8) == (uint16_t)lineSpacing) estimate = (std::max)(estimate, found->second);
+    }
+    return estimate;
+}
+
+//
+//Worker pool. The job and a generation count are handed over under the lock, the threads run the job once for each
+//new generation and check out under the lock again so the caller sees what they wrote.
+//
+
+WorkerPool::WorkerPool(int threadCount) {
+    workerCount = threadCount > 1 ? threadCount : 1;
+    job = nullptr;
+    jobData = nullptr;
+    generation = 0;
+    busyWorkers = 0;
+    stopping = false;
+
+    //the calling thread is the first worker
+    threads.reserve(workerCount - 1);
+    for(int i = 1; i < workerCount; i++) {
+        threads.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workReady.notify_all();
+
+    for(size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+}
+
+void WorkerPool::runJob(void (*job)(void* data, int worker), void* data) {
+    if(workerCount == 1) {
+        job(data, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->job = job;
+        jobData = data;
+        generation++;
+        busyWorkers = workerCount - 1;
+    }
+    workReady.notify_all();
+
+    job(data, 0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this] { return busyWorkers == 0; });
+}
+
+void WorkerPool::workerLoop(int worker) {
+    uint32_t doneGeneration = 0;
+
+    while(true) {
+        void (*currentJob)(void* data, int worker);
+        void* currentData;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workReady.wait(lock, [this, doneGeneration] { return stopping || generation != doneGeneration; });
+            if(stopping) {
+                return;
+            }
+            doneGeneration = generation;
+            currentJob = job;
+            currentData = jobData;
+        }
+
+        currentJob(currentData, worker);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        busyWorkers--;
+        if(busyWorkers == 0) {
+            workDone.notify_one();
+        }
+    }
+}
+
+//
+//Text measurement prepass. The text elements are gathered into a list and handed out to the pool's threads in 
+//batches, each thread measures with its own context.
+//
+
+const size_t TextMeasurementBatchSize = 16; // Texts a thread takes at a time
+
+template<typename Coord>
+void BasicMeasurementContextFactory<Coord>::destroyContext(BasicMeasurementContext<Coord>* measurementContext) {
+    delete measurementContext;
+}
+
+template<typename Coord>
+void collectTextElements(BasicBaseElement<Coord>* element, std::vector<BasicText<Coord>*>& texts) {
+    if(element->elementType == ElementTypeText) {
+        texts.push_back((BasicText<Coord>*)element);
+    }
+    else if(isContainerType(element->elementType)) {
+        BasicContainer<Coord>* container = (BasicContainer<Coord>*)element;
+        for(int i = 0; i < container->children.size(); i++) {
+            collectTextElements(container->children[i], texts);
+        }
+    }
+}
+
+//Measures the whole text and each word, the same measurements the fit and wrap passes would make
+template<typename Coord>
+void measureTextElement(BasicText<Coord>* textElement, BasicMeasurementContext<Coord>* measurementContext, std::vector<TextSpan>& words, std::string& word) {
+
+    std::string& text = textElement->text;
+    uint8_t font = textElement->font;
+    bool external = textElement->textBuffer != nullptr;
+    const char* data = textData(textElement);
+
+    checkTextBuffer(textElement);
+    textElement->maxContentWidth = external ? measurementContext->measureTextSpanWidth(data, textLength(textElement), font) : 
+        measurementContext->measureTextWidth(text, font);
+
+    splitStringByWhitesp(data, textLength(textElement), words);
+    textElement->wordAdvances.resize(words.size());
+    Coord longestWord = 0;
+
+    for(size_t i = 0; i < words.size(); i++) {
+        Coord wordWidth;
+        if(external) {
+            wordWidth = measurementContext->measureTextSpanWidth(data + words[i].offset, words[i].length, font);
+        }
+        else {
+            word.assign(text, words[i].offset, words[i].length);
+            wordWidth = measurementContext->measureTextWidth(word, font);
+        }
+        textElement->wordAdvances[i] = wordWidth;
+        longestWord = (std::max)(longestWord, wordWidth);
+    }
+
+    textElement->minContentWidth = longestWord;
+    textElement->measured = true;
+}
+
+//Measures batches of texts until none are left, nextText is shared by the threads doing it
+template<typename Coord>
+void measureTextBatches(std::vector<BasicText<Coord>*>& texts, std::atomic<size_t>& nextText, BasicMeasurementContext<Coord>* measurementContext,
+    std::vector<TextSpan>& words, std::string& word) {
+    size_t textCount = texts.size();
+
+    while(true) {
+        size_t begin = nextText.fetch_add(TextMeasurementBatchSize);
+        if(begin >= textCount) {
+            return;
+        }
+
+        size_t end = (std::min)(begin + TextMeasurementBatchSize, textCount);
+        for(size_t i = begin; i < end; i++) {
+            measureTextElement(texts[i], measurementContext, words, word);
+        }
+    }
+}
+
+template<typename Coord>
+BasicTextMeasurementPool<Coord>::BasicTextMeasurementPool(BasicMeasurementContextFactory<Coord>* factory, int threadCount) : 
+    pool(threadCount) {
+    this->factory = factory;
+    nextText = 0;
+
+    workers.resize(pool.getWorkerCount());
+    for(size_t i = 0; i < workers.size(); i++) {
+        workers[i].measurementContext = factory->createContext();
+    }
+}
+
+template<typename Coord>
+BasicTextMeasurementPool<Coord>::~BasicTextMeasurementPool() {
+    for(size_t i = 0; i < workers.size(); i++) {
+        factory->destroyContext(workers[i].measurementContext);
+    }
+}
+
+template<typename Coord>
+void BasicTextMeasurementPool<Coord>::measure(BasicContainer<Coord>* container) {
+
+    texts.clear();
+    collectTextElements<Coord>(container, texts);
+    nextText = 0;
+
+    auto measureJob = [this](int worker) {
+        measureTextBatches(texts, nextText, workers[worker].measurementContext, workers[worker].words, workers[worker].word);
+    };
+    pool.run(measureJob);
+}
+
+//
+//Multi breakpoint layout. The measure phase fills in the text measurements of the tree in parallel, the width fit 
+//then runs once on the calling thread and its layouts are kept. The threads that will lay out widths copy the tree, 
+//then each takes widths one at a time, starts its copy again from the kept fit and runs the rest of the passes on 
+//it. The first width is layed out on the tree itself, once nothing copies it anymore.
+//
+
+//Copies an element and everything under it over copy, with the computed layout and the text measurements. Where the 
+//element types match the copy's strings and vectors are reused, so copying the same tree again doesn't allocate. 
+//Returns the copy, a new one when copy is null or of another type.
+template<typename Coord>
+BasicBaseElement<Coord>* copySubtree(const BasicBaseElement<Coord>* element, BasicBaseElement<Coord>* copy, BasicContainer<Coord>* parent) {
+
+    if(copy != nullptr && copy->elementType != element->elementType) {
+        destroyElement<Coord>(copy);
+        copy = nullptr;
+    }
+
+    switch(element->elementType) {
+        case ElementTypeText:
+            if(copy == nullptr) copy = new BasicText<Coord>(*(const BasicText<Coord>*)element);
+            else *(BasicText<Coord>*)copy = *(const BasicText<Coord>*)element;
+            break;
+        case ElementTypePolygon:
+            if(copy == nullptr) copy = new BasicPolygon<Coord>(*(const BasicPolygon<Coord>*)element);
+            else *(BasicPolygon<Coord>*)copy = *(const BasicPolygon<Coord>*)element;
+            break;
+        case ElementTypeGrid:
+        {
+            const BasicGrid<Coord>* grid = (const BasicGrid<Coord>*)element;
+            if(copy == nullptr) copy = new BasicGrid<Coord>();
+            BasicGrid<Coord>* gridCopy = (BasicGrid<Coord>*)copy;
+            gridCopy->columnCount = grid->columnCount;
+            gridCopy->columnWidths = grid->columnWidths;
+            gridCopy->columnMinWidths = grid->columnMinWidths;
+            gridCopy->rowHeights = grid->rowHeights;
+            gridCopy->rowMinHeights = grid->rowMinHeights;
+            break;
+        }
+        default:
+            if(copy == nullptr) copy = new BasicContainer<Coord>();
+            break;
+    }
+
+    //containers keep their own children, the old copies are written over and the spare ones deleted
+    if(isContainerType(element->elementType)) {
+        *copy = *element;
+        const std::vector<BasicBaseElement<Coord>*>& children = ((const BasicContainer<Coord>*)element)->children;
+        std::vector<BasicBaseElement<Coord>*>& copies = ((BasicContainer<Coord>*)copy)->children;
+        for(size_t i = children.size(); i < copies.size(); i++) {
+            destroyElement<Coord>(copies[i]);
+        }
+        copies.resize(children.size(), nullptr);
+        for(size_t i = 0; i < children.size(); i++) {
+            copies[i] = copySubtree<Coord>(children[i], copies[i], (BasicContainer<Coord>*)copy);
+        }
+    }
+
+    copy->parent = parent;
+    return copy;
+}
+
+//Lists an element and everything under it in pre-order
+template<typename Coord>
+void flattenElements(BasicBaseElement<Coord>* element, std::vector<BasicBaseElement<Coord>*>& elements) {
+    elements.push_back(element);
+    if(isContainerType(element->elementType)) {
+        BasicContainer<Coord>* container = (BasicContainer<Coord>*)element;
+        for(size_t i = 0; i < container->children.size(); i++) {
+            flattenElements(container->children[i], elements);
+        }
+    }
+}
+
+template<typename Coord>
+BasicBreakpointLayout<Coord>::BasicBreakpointLayout(BasicMeasurementContextFactory<Coord>* factory, int threadCount) : 
+    pool(threadCount) {
+    this->factory = factory;
+    root = nullptr;
+    rootWidth = LengthAuto;
+    resultCount = 0;
+    nextItem = 0;
+
+    workers.resize(pool.getWorkerCount());
+    for(size_t i = 0; i < workers.size(); i++) {
+        workers[i].measurementContext = factory->createContext();
+        workers[i].copy = nullptr;
+    }
+}
+
+template<typename Coord>
+BasicBreakpointLayout<Coord>::~BasicBreakpointLayout() {
+    for(size_t i = 0; i < workers.size(); i++) {
+        factory->destroyContext(workers[i].measurementContext);
+        if(workers[i].copy != nullptr) {
+            destroyElement<Coord>(workers[i].copy);
+        }
+    }
+}
+
+template<typename Coord>
+void BasicBreakpointLayout<Coord>::layout(BasicContainer<Coord>* root, const Coord* widths, size_t widthCount) {
+
+    //the results of the last call keep their storage to be written over
+    resultCount = widthCount;
+    if(results.size() < widthCount) {
+        results.resize(widthCount);
+    }
+    for(size_t i = 0; i < widthCount; i++) {
+        results[i].width = widths[i];
+    }
+    elements.clear();
+    if(widthCount == 0) {
+        return;
+    }
+    this->root = root;
+    rootWidth = root->width;
+
+    //the shared work, measured once and fitted once whatever the number of widths
+    initElements(root, (BasicContainer<Coord>*)nullptr);
+    texts.clear();
+    collectTextElements<Coord>(root, texts);
+    nextItem = 0;
+    auto measureJob = [this](int worker) {
+        measureTextBatches(texts, nextItem, workers[worker].measurementContext, workers[worker].layoutContext.words, 
+            workers[worker].layoutContext.word);
+    };
+    pool.run(measureJob);
+    computeFitSizing<Coord, AxisX<Coord>>(root, workers[0].measurementContext, &workers[0].layoutContext);
+
+    flattenElements<Coord>(root, elements);
+    fitLayouts.resize(elements.size());
+    for(size_t i = 0; i < elements.size(); i++) {
+        fitLayouts[i] = elements[i]->layout;
+    }
+
+    //a thread lays out at most every width, so only that many threads need a copy
+    if(widthCount > 1) {
+        auto copyJob = [this](int worker) {
+            if((size_t)worker < resultCount) {
+                copyTree(&workers[worker]);
+            }
+        };
+        pool.run(copyJob);
+    }
+
+    nextItem = 0;
+    auto widthJob = [this](int worker) {
+        if((size_t)worker < resultCount) {
+            layoutWidths(&workers[worker]);
+        }
+    };
+    pool.run(widthJob);
+
+    //the measurements were only for this call, a later layout of the tree must measure again
+    root->width = rootWidth;
+    for(size_t i = 0; i < texts.size(); i++) {
+        texts[i]->measured = false;
+    }
+    this->root = nullptr;
+}
+
+template<typename Coord>
+void BasicBreakpointLayout<Coord>::copyTree(Worker* worker) {
+    worker->copy = (BasicContainer<Coord>*)copySubtree<Coord>(root, worker->copy, (BasicContainer<Coord>*)nullptr);
+    worker->elements.clear();
+    flattenElements<Coord>(worker->copy, worker->elements);
+}
+
+template<typename Coord>
+void BasicBreakpointLayout<Coord>::layoutWidths(Worker* worker) {
+    while(true) {
+        size_t index = nextItem.fetch_add(1);
+        if(index >= resultCount) {
+            return;
+        }
+        layoutWidth(worker, index);
+    }
+}
+
+template<typename Coord>
+void BasicBreakpointLayout<Coord>::layoutWidth(Worker* worker, size_t index) {
+    BasicMeasurementContext<Coord>* measurementContext = worker->measurementContext;
+    LayoutContext* layoutContext = &worker->layoutContext;
+    Coord width = results[index].width;
+
+    //the first width goes on the tree, which still holds the fit. A copy is put back to the fit, the grids' column
+    //tracks are worked out again from it and the texts use their measurements again.
+    std::vector<BasicBaseElement<Coord>*>& treeElements = index == 0 ? elements : worker->elements;
+    if(index > 0) {
+        for(size_t i = 0; i < treeElements.size(); i++) {
+            treeElements[i]->layout = fitLayouts[i];
+            if(treeElements[i]->elementType == ElementTypeText) {
+                ((BasicText<Coord>*)treeElements[i])->measured = true;
+            }
+        }
+        for(size_t i = 0; i < treeElements.size(); i++) {
+            if(treeElements[i]->elementType == ElementTypeGrid) {
+                typename CoordTraits<Coord>::Accumulator contentSize = 0;
+                typename CoordTraits<Coord>::Accumulator minContentSize = 0;
+                BasicGrid<Coord>* grid = (BasicGrid<Coord>*)treeElements[i];
+                computeGridTracks<Coord, AxisX<Coord>>(grid, getStyle<Coord>(grid->style), contentSize, minContentSize);
+            }
+        }
+    }
+
+    //the root is set to this width, then the passes run as layout runs them after the width fit
+    BasicContainer<Coord>* tree = (BasicContainer<Coord>*)treeElements[0];
+    tree->width = width;
+    tree->layout.width = width;
+    tree->layout.fitWidth = width;
+
+    computeGrowSizing<Coord, AxisX<Coord>>(tree, measurementContext, layoutContext);
+    computeTextWrapping(tree, measurementContext, layoutContext);
+    computeFitSizing<Coord, AxisY<Coord>>(tree, measurementContext, layoutContext);
+    computeGrowSizing<Coord, AxisY<Coord>>(tree, measurementContext, layoutContext);
+    computePositions(tree, layoutContext);
+    tree->width = rootWidth;
+
+    //the layouts and the lines as they are shown go into the result's arrays
+    Result& result = results[index];
+    size_t elementCount = treeElements.size();
+    result.layouts.resize(elementCount);
+    result.firstLines.resize(elementCount + 1);
+    result.lines.clear();
+    result.text.clear();
+    for(size_t i = 0; i < elementCount; i++) {
+        BasicBaseElement<Coord>* element = treeElements[i];
+        result.layouts[i] = element->layout;
+        result.firstLines[i] = (uint32_t)result.lines.size();
+        if(element->elementType != ElementTypeText) {
+            continue;
+        }
+
+        BasicText<Coord>* textElement = (BasicText<Coord>*)element;
+        if(textElement->textBuffer != nullptr) {
+            for(size_t line = 0; line < textElement->wrappedSpans.size(); line++) {
+                const TextSpan& span = textElement->wrappedSpans[line];
+                result.lines.push_back(TextSpan{(uint32_t)result.text.size(), span.length});
+                result.text.append(textElement->textBuffer->data + span.offset, span.length);
+            }
+            if(textElement->truncated && !textElement->wrappedSpans.empty()) {
+                result.text.append(Ellipsis, EllipsisLength);
+                result.lines.back().length += (uint32_t)EllipsisLength;
+            }
+        }
+        else {
+            for(size_t line = 0; line < textElement->wrappedText.size(); line++) {
+                result.lines.push_back(TextSpan{(uint32_t)result.text.size(), (uint32_t)textElement->wrappedText[line].size()});
+                result.text += textElement->wrappedText[line];
+            }
+        }
+    }
+    result.firstLines[elementCount] = (uint32_t)result.lines.size();
+}
+
+template<typename Coord>
+size_t BasicBreakpointLayout<Coord>::getResultCount() const {
+    return resultCount;
+}
+
+template<typename Coord>
+Coord BasicBreakpointLayout<Coord>::getResultWidth(size_t index) const {
+    return results[index].width;
+}
+
+template<typename Coord>
+size_t BasicBreakpointLayout<Coord>::getElementCount() const {
+    return elements.size();
+}
+
+template<typename Coord>
+BasicBaseElement<Coord>* BasicBreakpointLayout<Coord>::getElement(size_t element) const {
+    return elements[element];
+}
+
+template<typename Coord>
+const BasicComputedLayout<Coord>& BasicBreakpointLayout<Coord>::getLayout(size_t index, size_t element) const {
+    return results[index].layouts[element];
+}
+
+template<typename Coord>
+uint32_t BasicBreakpointLayout<Coord>::getLineCount(size_t index, size_t element) const {
+    const Result& result = results[index];
+    return result.firstLines[element + 1] - result.firstLines[element];
+}
+
+template<typename Coord>
+const char* BasicBreakpointLayout<Coord>::getLine(size_t index, size_t element, uint32_t line, uint32_t* length) const {
+    const Result& result = results[index];
+    TextSpan span = result.lines[result.firstLines[element] + line];
+    *length = span.length;
+    return result.text.data() + span.offset;
+}
+
+//
+//Paginated layout, children are streamed through one page at a time
+//
+
+template<typename Coord>
+void destroyElement(BasicBaseElement<Coord>* element) {
+    switch(element->elementType) {
+        case ElementTypeContainer:
+        case ElementTypeGrid: {
+            BasicContainer<Coord>* container = (BasicContainer<Coord>*)element;
+            for(size_t i = 0; i < container->children.size(); i++) {
+                destroyElement(container->children[i]);
+            }
+            if(element->elementType == ElementTypeGrid) delete (BasicGrid<Coord>*)element;
+            else delete container;
+            break;
+        }
+        case ElementTypeText:
+            delete (BasicText<Coord>*)element;
+            break;
+        case ElementTypePolygon:
+            delete (BasicPolygon<Coord>*)element;
+            break;
+    }
+}
+
+template<typename Coord>
+void BasicPageStream<Coord>::releaseChild(BasicBaseElement<Coord>* child) {
+    destroyElement(child);
+}
+
+//Splits a wrapped text element after its first lineCount lines. The element keeps those lines and 
+//the rest moves into a new continuation element with the same settings.
+template<typename Coord>
+BasicText<Coord>* splitTextAtLine(BasicText<Coord>* textElement, size_t lineCount, LayoutContext* layoutContext){
+    BasicText<Coord>* continuation = new BasicText<Coord>(*textElement);
+
+    //external text is split by narrowing the spans, both halves keep pointing into the buffer
+    if(textElement->textBuffer != nullptr) {
+        uint32_t textEnd = textElement->textSpan.offset + textElement->textSpan.length;
+        const TextSpan& firstCarried = textElement->wrappedSpans[lineCount];
+        const TextSpan& lastKept = textElement->wrappedSpans[lineCount - 1];
+        continuation->textSpan = {firstCarried.offset, textEnd - firstCarried.offset};
+        continuation->wrappedSpans.clear();
+        textElement->textSpan.length = lastKept.offset + lastKept.length - textElement->textSpan.offset;
+        textElement->wrappedSpans.resize(lineCount);
+        return continuation;
+    }
+
+    //owned text is cut at the first word of the first carried line, the wrapped lines hold one space between 
+    //words so counting them finds that word, and both halves keep the whitespace of the text as it was
+    std::vector<TextSpan>& words = layoutContext->words;
+    splitStringByWhitesp(textElement->text, words);
+    size_t wordIndex = 0;
+    for(size_t i = 0; i < lineCount; i++) {
+        const std::string& line = textElement->wrappedText[i];
+        wordIndex += std::count(line.begin(), line.end(), ' ') + 1;
+    }
+
+    const TextSpan& firstCarried = words[wordIndex];
+    const TextSpan& lastKept = words[wordIndex - 1];
+    continuation->text.assign(textElement->text, firstCarried.offset, std::string::npos);
+    continuation->wrappedText.clear();
+    textElement->text.resize(lastKept.offset + lastKept.length);
+    textElement->wrappedText.resize(lineCount);
+    return continuation;
+}
+
+//Hands the finished page to the stream and releases its children. When every child was moved into place from its 
+//probe only the page's own box is set, which is what a layout of the page would give it, else the page is layed out.
+template<typename Coord>
+void finishPage(BasicContainer<Coord>* page, Coord pageHeight, bool placed, const BasicContainer<Coord>& probe, 
+    typename CoordTraits<Coord>::Accumulator childMinHeight, BasicPageStream<Coord>* stream, 
+    BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext, 
+    int& pageIndex, std::vector<BasicBaseElement<Coord>*>& continuations){
+
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
+
+    if(placed) {
+        const BasicStyle<Coord>* style = getStyle<Coord>(page->style);
+        Accum sumSpace = (Accum)style->paddingTop + style->paddingBottom + 2 * (Accum)style->borderWidth;
+        page->parent = nullptr;
+        page->layout.width = probe.layout.width;
+        page->layout.fitWidth = probe.layout.fitWidth;
+        page->layout.minWidth = probe.layout.minWidth;
+        page->layout.height = pageHeight;
+        page->layout.fitHeight = pageHeight;
+        page->layout.minHeight = page->minHeight >= 0 ? page->minHeight : toCoord<Coord>(sumSpace + childMinHeight);
+    }
+    else {
+        Coord height = page->height;
+        page->height = pageHeight;
+        layout(page, measurementContext, layoutContext);
+        page->height = height;
+    }
+
+    stream->consumePage(page, pageIndex);
+    pageIndex++;
+
+    //continuations were made by the engine so they are deleted here, everything else goes back to the stream
+    for(size_t i = 0; i < page->children.size(); i++) {
+        BasicBaseElement<Coord>* child = page->children[i];
+        
+        bool isContinuation = false;
+        for(size_t j = 0; j < continuations.size(); j++) {
+            if(continuations[j] == child) {
+                continuations[j] = continuations.back();
+                continuations.pop_back();
+                isContinuation = true;
+                break;
+            }
+        }
+
+        if(isContinuation) delete (BasicText<Coord>*)child;
+        else stream->releaseChild(child);
+    }
+    page->children.clear();
+}
+
+template<typename Coord>
+int layoutPaginated(BasicContainer<Coord>* page, Coord pageHeight, BasicPageStream<Coord>* stream, 
+    BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext){
+
+    typedef typename CoordTraits<Coord>::Accumulator Accum;
+
+    const BasicStyle<Coord>* style = getStyle<Coord>(page->style);
+    Accum contentHeight = (Accum)pageHeight - style->paddingTop - style->paddingBottom - 2 * (Accum)style->borderWidth;
+
+    //each child is layed out on its own in a probe with the page's width, style and position. With a set page width 
+    //and no growing child the page would give each child the same box, so the child is only moved down into place
+    BasicContainer<Coord> probe;
+    probe.style = page->style;
+    probe.width = page->width;
+    probe.minWidth = page->minWidth;
+    probe.maxWidth = page->maxWidth;
+    probe.layout.x = page->layout.x;
+    probe.layout.y = page->layout.y;
+    bool canPlace = page->width >= 0 && style->layoutDirection == LayoutColumn;
+
+    std::vector<BasicBaseElement<Coord>*> continuations; // Text continuations created by splitting, owned by the engine
+    BasicBaseElement<Coord>* pending = nullptr; // Child carried over to the next page
+    bool pendingProbed = false; // The carried child didn't fit and still has its probe layout
+    Accum usedHeight = 0;
+    Accum childMinHeight = 0; // Min heights of the children on the page and the gaps between them
+    bool placed = true; // Every child on the page was moved into place from its probe
+    int pageIndex = 0;
+
+    while(true) {
+        BasicBaseElement<Coord>* child = pending ? pending : stream->nextChild();
+        bool probed = pendingProbed;
+        pending = nullptr;
+        pendingProbed = false;
+        if(!child) break;
+
+        if(!probed) {
+            probe.children.assign(1, child);
+            layout(&probe, measurementContext, layoutContext);
+            probe.children.clear();
+        }
+
+        Accum childHeight = child->layout.height;
+        Accum gap = page->children.empty() ? 0 : style->gap;
+        bool fits = usedHeight + gap + childHeight <= contentHeight;
+
+        //text can be split at a line boundary, the first lines finish this page and the rest carry over
+        if(!fits && child->elementType == ElementTypeText && child->height < 0) {
+            BasicText<Coord>* textElement = (BasicText<Coord>*)child;
+            const BasicStyle<Coord>* textStyle = getStyle<Coord>(textElement->style);
+            Accum chrome = (Accum)textStyle->paddingTop + textStyle->paddingBottom + 2 * (Accum)textStyle->borderWidth;
+            Accum lineHeight = measurementContext->getLineHeight(TextLineSpacing, textElement->font);
+            Accum linesThatFit = lineHeight > 0 ? (contentHeight - usedHeight - gap - chrome) / lineHeight : 0;
+
+            if(linesThatFit > 0 && linesThatFit < (Accum)wrappedLineCount(textElement)) {
+                pending = splitTextAtLine(textElement, (size_t)linesThatFit, layoutContext);
+                continuations.push_back(pending);
+
+                //the kept lines wrap the same way, the probe only has to give them their new height
+                probe.children.assign(1, child);
+                layout(&probe, measurementContext, layoutContext);
+                probe.children.clear();
+                fits = true;
+            }
+        }
+
+        //doesn't fit, it starts the next page, or goes on its own and overflows if the page is already empty
+        if(!fits && !page->children.empty()) {
+            pending = child;
+            pendingProbed = true;
+            finishPage(page, pageHeight, placed, probe, childMinHeight, stream, measurementContext, layoutContext, pageIndex, continuations);
+            usedHeight = 0;
+            childMinHeight = 0;
+            placed = true;
+            continue;
+        }
+
+        //an overflowing child is shrunk by the page layout, so it can't just be moved
+        placed = placed && fits && canPlace && child->grow <= 0;
+        if(placed) offsetElement(child, usedHeight + gap, layoutContext);
+        child->parent = page;
+        page->children.push_back(child);
+        usedHeight += gap + child->layout.height;
+        childMinHeight += gap + child->layout.minHeight;
+
+        //a split text or an overflowing child fills the page
+        if(pending != nullptr || !fits) {
+            finishPage(page, pageHeight, placed, probe, childMinHeight, stream, measurementContext, layoutContext, pageIndex, continuations);
+            usedHeight = 0;
+            childMinHeight = 0;
+            placed = true;
+        }
+    }
+
+    if(!page->children.empty()) {
+        finishPage(page, pageHeight, placed, probe, childMinHeight, stream, measurementContext, layoutContext, pageIndex, continuations);
+    }
+
+    return pageIndex;
+}
+
+//
+//Instantiations for the supported coordinate types
+//
+
+#define TINY_LAYOUT_ENGINE_INSTANTIATE(Coord) \
+    template struct BasicStyle<Coord>; \
+    template class BasicMeasurementContext<Coord>; \
+    template class BasicBaseElement<Coord>; \
+    template class BasicContainer<Coord>; \
+    template class BasicGrid<Coord>; \
+    template class BasicText<Coord>; \
+    template class BasicPolygon<Coord>; \
+    template StyleHandle internStyle<Coord>(const BasicStyle<Coord>& style); \
+    template StyleHandle createStyle<Coord>(const BasicStyle<Coord>& style); \
+    template void setStyle<Coord>(StyleHandle handle, const BasicStyle<Coord>& style); \
+    template const BasicStyle<Coord>* getStyle<Coord>(StyleHandle handle); \
+    template void layout<Coord>(BasicContainer<Coord>* container, BasicMeasurementContext<Coord>* measurementContext); \
+    template void layout<Coord>(BasicContainer<Coord>* container, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext); \
+    template void layoutProfiled<Coord>(BasicContainer<Coord>* container, BasicMeasurementContext<Coord>* measurementContext, \
+        LayoutContext* layoutContext, double passSeconds[LayoutPassCount]); \
+    template bool layoutAppended<Coord>(BasicContainer<Coord>* column, size_t firstNewChild, \
+        BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext); \
+    template Coord resolveMinWidth<Coord>(BasicBaseElement<Coord>* element, BasicMeasurementContext<Coord>* measurementContext, \
+        LayoutContext* layoutContext); \
+    template class BasicLayoutJob<Coord>; \
+    template class BasicAsyncLayout<Coord>; \
+    template class BasicMeasurementContextFactory<Coord>; \
+    template class BasicTextMeasurementPool<Coord>; \
+    template class BasicBreakpointLayout<Coord>; \
+    template class BasicPageStream<Coord>; \
+    template void destroyElement<Coord>(BasicBaseElement<Coord>* element); \
+    template int layoutPaginated<Coord>(BasicContainer<Coord>* page, Coord pageHeight, BasicPageStream<Coord>* stream, \
+        BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext);
+
+TINY_LAYOUT_ENGINE_INSTANTIATE(int16_t)
+TINY_LAYOUT_ENGINE_INSTANTIATE(int32_t)
+TINY_LAYOUT_ENGINE_INSTANTIATE(float)
 
 } // namespace TinyLayoutEngine
@@ -1,17 +1,30 @@
 #ifndef TINY_LAYOUT_ENGINE_HPP
 #define TINY_LAYOUT_ENGINE_HPP
 
+#include <cstdint>
+#include <cstddef>
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 namespace TinyLayoutEngine {
 
 enum ElementType : int8_t {
     ElementTypeContainer, // A container that can hold other elements
     ElementTypeText, // A text element
-    ElementTypePolygon // A polygon element
+    ElementTypePolygon, // A polygon element
+    ElementTypeGrid // A container whose children are cells laid out on shared column and row tracks
 };
 
+//Containers and grids both hold children
+inline bool isContainerType(ElementType elementType) {
+    return elementType == ElementTypeContainer || elementType == ElementTypeGrid;
+}
+
 enum Positioning : int8_t {
     PositionFree, // Free positioning, element can be placed anywhere using x, y coordinates
     PositionLayout // Layout positioning, element is positioned based on the layout rules of its container
@@ -63,75 +76,170 @@ struct Color {
     uint8_t a; 
 };
 
-//This is the computed layout after running the layout function, size of 12 bytes
-struct ComputedLayout {
-    int16_t x; // Computed x position of the element
-    int16_t y; // Computed y position of the element
-    int16_t minWidth; // Computed minimum width of the element
-    int16_t minHeight; // Computed minimum height of the element
-    int16_t width; // Computed width of the element
-    int16_t height; // Computed height of the element
+//The engine is templated on its coordinate type. int16_t is compact for embedded targets, int32_t handles 
+//long documents and float gives sub-pixel layout. Sums of coordinates are done in the wider accumulator type.
+template<typename Coord> struct CoordTraits;
+template<> struct CoordTraits<int16_t> { typedef int32_t Accumulator; };
+template<> struct CoordTraits<int32_t> { typedef int64_t Accumulator; };
+template<> struct CoordTraits<float> { typedef double Accumulator; };
+
+//This is the computed layout after running the layout function, size of 6 coordinates
+template<typename Coord>
+struct BasicComputedLayout {
+    Coord x; // Computed x position of the element
+    Coord y; // Computed y position of the element
+    Coord minWidth; // Computed minimum width of the element, only when a shrinking container needed it, else LengthAuto, see resolveMinWidth
+    Coord minHeight; // Computed minimum height of the element
+    Coord width; // Computed width of the element
+    Coord height; // Computed height of the element
+    Coord fitWidth; // Width from the content before growing and shrinking, kept for incremental layout
+    Coord fitHeight; // Height from the content before growing and shrinking
 }; 
 
-//Base class for all elements, size of 47 bytes
-class BaseElement {
+//Shared, immutable style record. Records are interned so elements with the same style share one record
+//and two styles are equal exactly when their record pointers are equal.
+template<typename Coord>
+struct BasicStyle {
+    Coord borderWidth; // Border width of the element
+    Coord borderRadius; // Border radius for rounded corners
+
+    Coord paddingLeft; // Padding around the content
+    Coord paddingRight;
+    Coord paddingTop;
+    Coord paddingBottom;
+
+    Coord marginLeft; // Margin around the element, also used as x and y offset for free positioned elements
+    Coord marginRight; 
+    Coord marginTop; 
+    Coord marginBottom; 
+
+    Coord gap; // Gap between elements in a container
+
+    Color backgroundColor; // Background color of the element
+    Color borderColor; // Border color of the element
+
+    Alignment alignSelf; // Self-alignment of the element within its container
+    Alignment alignItems; // Alignment of the content within a container
+    Justification justifyContent; // Justification of the content within a container
+    LayoutDirection layoutDirection; // Direction of a container's layout (row or column)
+    OverflowMode overflow; // Overflow behavior of a container
+
+    BasicStyle();
+
+    bool operator==(const BasicStyle& other) const;
+};
+
+//Elements reference their style through a small handle into the process wide style table. 
+//Handle 0 is the default style. Each handle points at an interned record, rebinding a handle 
+//restyles every element that uses it without walking the tree. There is one table per coordinate type.
+//
+//The style table isn't thread safe. Create and set styles from one thread, and not while a layout, a measurement 
+//pool or a breakpoint layout is running, their threads read styles without locking so the table must stay frozen.
+typedef uint16_t StyleHandle;
+
+const StyleHandle DefaultStyle = 0;
+const StyleHandle MaxStyleHandle = 0xFFFF; // The last handle, a table holds at most 65536 of them
+
+//Returns the shared handle for the record, elements with the same style get the same handle. 
+//Use this for per element overrides, these handles are never rebound by the engine.
+//Once every handle is used up debug builds assert and DefaultStyle is returned.
+template<typename Coord>
+StyleHandle internStyle(const BasicStyle<Coord>& style);
+
+//Creates a new handle that can later be rebound with setStyle, use this for themeable styles.
+//Runs out like internStyle.
+template<typename Coord>
+StyleHandle createStyle(const BasicStyle<Coord>& style);
+
+//Rebinds the handle to a new record, every element using the handle picks up the new style.
+//Handles that were never created are ignored, debug builds assert on them.
+template<typename Coord>
+void setStyle(StyleHandle handle, const BasicStyle<Coord>& style);
+
+//Gets the interned record of a handle, debug builds check that the handle was created.
+template<typename Coord = int16_t>
+const BasicStyle<Coord>* getStyle(StyleHandle handle);
+
+template<typename Coord>
+class BasicContainer;
+
+//Base class for all elements, size of 48 bytes with int16_t coordinates
+template<typename Coord>
+class BasicBaseElement {
 public:
     
-    ComputedLayout layout; // Computed layout of the element
-    
-    int16_t borderWidth; // Border width of the container
-    int16_t borderRadius; // Border radius for rounded corners
+    BasicComputedLayout<Coord> layout; // Computed layout of the element
     
-    int16_t width; // Width of the element
-    int16_t height; // Height of the element
-    int16_t maxWidth; // Maximum width of the element
-    int16_t maxHeight; // Maximum height of the element
-    int16_t minWidth; // Minimum width of the element
-    int16_t minHeight; // Minimum height of the element
-    
-    int16_t paddingLeft; // Padding around the content
-    int16_t paddingRight;
-    int16_t paddingTop;
-    int16_t paddingBottom;
+    Coord width; // Width of the element
+    Coord height; // Height of the element
+    Coord maxWidth; // Maximum width of the element
+    Coord maxHeight; // Maximum height of the element
+    Coord minWidth; // Minimum width of the element
+    Coord minHeight; // Minimum height of the element
 
-    int16_t marginLeft; // Margin around the element, also used as x and y offset for free positioned elements
-    int16_t marginRight; 
-    int16_t marginTop; 
-    int16_t marginBottom; 
+    StyleHandle style; // Handle of the element's style, padding, margins, border, colors, alignment etc.
 
     int8_t grow; // Grow factor for the element in the layout (for flexbox-like behavior)
     int8_t zIndex; // Z-index for stacking order of the element
 
-    Color backgroundColor; // Background color of the container
-    Color borderColor; // Border color of the container
-
     ElementType elementType; // Type of the element (container, text, polygon)
     Positioning positioning; // Positioning of the element in the layout
-    Alignment alignSelf; // Self-alignment of the element within its container
 
     bool visible; // Whether the element is visible (still layouted but not drawn)
     bool displayed; // Whether the element is layouted and takes space in the layout
 
-    BaseElement(); 
+    BasicContainer<Coord>* parent; // Container holding the element in the last layout, set by the layout
+
+    BasicBaseElement(); 
 }; 
 
 
-class Container: public BaseElement {
+template<typename Coord>
+class BasicContainer: public BasicBaseElement<Coord> {
 public:
-    std::vector<BaseElement*> children; // List of child elements in the container
+    std::vector<BasicBaseElement<Coord>*> children; // List of child elements in the container, gap, direction and alignment come from the style
 
-    int16_t gap; // Gap between elements in a container
-    
-    OverflowMode overflow; // Overflow behavior of the container
+    BasicContainer();
+}; 
 
-    LayoutDirection layoutDirection; // Direction of the layout (row or column)
-    Justification justifyContent; // Justification of the content within the container
-    Alignment alignItems; // Alignment of the content within the container
+//A grid lays its children out as cells in row major order, columnCount cells per row. Column widths are 
+//resolved once from every cell's intrinsic width, so columns line up and a large table is sized in one pass
+//over the cells instead of one flex solve per row. The style's gap is used between columns and rows.
+template<typename Coord>
+class BasicGrid: public BasicContainer<Coord> {
+public:
+    uint16_t columnCount; // Number of cells in each row
 
-    Container();
-}; 
+    std::vector<Coord> columnWidths; // Resolved column track widths, computed by layout
+    std::vector<Coord> columnMinWidths; // Min content width of each column, computed by layout when needed, else empty
+    std::vector<Coord> rowHeights; // Resolved row track heights, computed by layout
+    std::vector<Coord> rowMinHeights; // Min content height of each row, computed by layout
+
+    BasicGrid();
+};
+
+//A run of characters inside a string, used for words and lines without copying them out
+struct TextSpan {
+    uint32_t offset; // Offset of the first character
+    uint32_t length; // Number of characters
+};
+
+//A caller owned block of text, like a mapped file or a region of the WASM heap, that text elements can show without
+//copying it. The memory must stay valid and unchanged and the buffer object alive for as long as any element
+//references it. Debug builds check on every layout that the buffer is still alive and the element's span is inside it.
+class TextBuffer {
+public:
+    const char* data;
+    size_t size;
 
-class Text: public BaseElement {
+    TextBuffer(const char* data, size_t size);
+    ~TextBuffer();
+    TextBuffer(const TextBuffer&) = delete;
+    TextBuffer& operator=(const TextBuffer&) = delete;
+};
+
+template<typename Coord>
+class BasicText: public BasicBaseElement<Coord> {
 public:
     std::string text; // The text content of the element
     std::vector<std::string> wrappedText; // The text split into lines after wrapping
@@ -139,34 +247,457 @@ public:
     TextAlignment textAlign; // Text alignment within it's container
     uint8_t font; //There are a maximum of 256 pre defined fonts. This includes face, size, bold, italic etc.
 
-    Text();
+    //External text, used instead of text when textBuffer is set. Words are read straight from the buffer and the 
+    //wrapped lines are spans into it, from the first character of a line's first word to the last of its last word.
+    const TextBuffer* textBuffer; // Caller owned buffer holding the text, or nullptr
+    TextSpan textSpan; // The part of the buffer this element shows
+    std::vector<TextSpan> wrappedSpans; // The wrapped lines as spans into the buffer, wrappedText stays empty
+
+    //Truncation. With OverflowHide in the style the text is cut after maxLines lines and the last line ends in an 
+    //ellipsis, as is a last line made of a word too wide for the box. The ellipsis is part of the line in wrappedText,
+    //wrappedSpans can't hold it so renderers of external text add it themselves when truncated is set.
+    uint16_t maxLines; // Lines kept with OverflowHide, 0 for no limit
+    bool truncated; // Set by the layout when the text was cut
+    TextSpan truncatedSpan; // The text kept before the ellipsis, an offset into text or into the buffer like wrappedSpans
+
+    //Results of the text measurement prepass, consumed and invalidated by the next layout
+    bool measured; // The fields below are valid
+    Coord maxContentWidth; // Width of the whole text on one line
+    Coord minContentWidth; // Width of the longest word
+    std::vector<Coord> wordAdvances; // Width of each word, in the order they appear
+
+    BasicText();
 }; 
 
-class Polygon: public BaseElement {
+//A polygon is sized by the bounds of its points and the points are scaled into the content box it gets. The geometry
+//a renderer needs is built by the layout and kept on the polygon, it is only rebuilt when the points, fill, stroke or 
+//the size of the box change, when the box only moves it is moved along. The stroke is the style's border width wide, 
+//at least 1.
+template<typename Coord>
+class BasicPolygon: public BasicBaseElement<Coord> {
 public:
-    std::vector<int16_t> points; // List of x, y pairs
+    std::vector<Coord> points; // List of x, y pairs
     bool fill; // Whether to fill the polygon
     bool stroke; // Whether to draw the stroke
 
-    Polygon(); 
+    Coord bounds[4]; // Left, top, right and bottom of the points, set by the layout
+
+    std::vector<Coord> boxPoints; // The points scaled and moved into the content box, x, y pairs
+    std::vector<uint32_t> fillTriangles; // Index triples into boxPoints covering the inside, empty without fill
+    std::vector<Coord> strokeOutline; // Triangle strip along the edges as x, y pairs, empty without stroke
+
+    std::vector<Coord> geometryPoints; // What the geometry was built from
+    Coord geometryBox[4]; // Content box left and top the geometry is at, width and height it was built for
+    Coord geometryStrokeWidth; // 0 without stroke
+    bool geometryFill;
+    bool geometryValid;
+
+    BasicPolygon(); 
 };
 
 //This is the interface that the layout engine uses to measure text and the like. It must be provided. 
-class BaseMeasurementContext {
+template<typename Coord>
+class BasicMeasurementContext {
 public:
 
-    virtual ~BaseMeasurementContext() = default; // add this
+    virtual ~BasicMeasurementContext() = default; // add this
 
     // Measure the width of the given text with the given font properties
-    virtual int16_t measureTextWidth(std::string& str, uint8_t font) = 0;
+    virtual Coord measureTextWidth(std::string& str, uint8_t font) = 0;
+
+    // Same for text that isn't in a string, used for external text. By default it is copied into one and measured 
+    // with measureTextWidth, override it to measure in place.
+    virtual Coord measureTextSpanWidth(const char* str, size_t length, uint8_t font);
+
+    //Writes the width of the text up to the end of each byte into advances, length entries, so truncation can find 
+    //where to cut with one measurement. The bytes of a character or cluster all get the width up to its end so the 
+    //text is never cut inside one. Returns false when not supported, the default, then prefixes are measured instead.
+    virtual bool measureTextAdvances(const char* str, size_t length, uint8_t font, Coord* advances);
 
     //Gets the standard line height of a font, this is (ascent + descent * lineSpacing)
-    virtual int16_t getLineHeight(int16_t lineSpacing, uint8_t font) = 0;
+    virtual Coord getLineHeight(int16_t lineSpacing, uint8_t font) = 0;
+};
+
+//Creates the measurement contexts used by the measurement prepass, one per thread. The contexts must give the same 
+//results as the one passed to layout. 
+template<typename Coord>
+class BasicMeasurementContextFactory {
+public:
+
+    virtual ~BasicMeasurementContextFactory() = default;
+
+    //Creates a context, it is only ever used by one thread at a time
+    virtual BasicMeasurementContext<Coord>* createContext() = 0;
+
+    //Destroys a context made by createContext, by default it is deleted
+    virtual void destroyContext(BasicMeasurementContext<Coord>* measurementContext);
+};
+
+//Source and sink of a paginated document, implemented by the caller. The engine pulls children one at a time, 
+//packs them into fixed height pages and hands each page over as soon as it is full, so only one page is alive at once.
+template<typename Coord>
+class BasicPageStream {
+public:
+
+    virtual ~BasicPageStream() = default;
+
+    //Returns the next child of the document, or nullptr once the document is finished
+    virtual BasicBaseElement<Coord>* nextChild() = 0;
+
+    //Receives each finished and layed out page, its children are released straight after this returns
+    virtual void consumePage(BasicContainer<Coord>* page, int pageIndex) = 0;
+
+    //Releases a child returned by nextChild once its page is consumed, by default it is deleted along with its subtree
+    virtual void releaseChild(BasicBaseElement<Coord>* child);
+};
+
+//The default int16_t engine, the other coordinate types are used through the Basic templates directly
+typedef BasicComputedLayout<int16_t> ComputedLayout;
+typedef BasicStyle<int16_t> Style;
+typedef BasicBaseElement<int16_t> BaseElement;
+typedef BasicContainer<int16_t> Container;
+typedef BasicGrid<int16_t> Grid;
+typedef BasicText<int16_t> Text;
+typedef BasicPolygon<int16_t> Polygon;
+typedef BasicMeasurementContext<int16_t> BaseMeasurementContext;
+typedef BasicPageStream<int16_t> PageStream;
+typedef BasicMeasurementContextFactory<int16_t> MeasurementContextFactory;
+
+
+//Scratch storage owned by the caller and reused between layout calls. Once a tree has been layed out 
+//with a context, laying out the same tree shape again with it does not touch the heap.
+class LayoutContext {
+public:
+    std::vector<TextSpan> words; // Word spans of the text element currently being measured or wrapped
+    std::string word; // The current word, copied out so it can be measured
+    std::string currentLine; // The line being built while wrapping
+    std::string testLine; // The current line plus the next word, used to test if the word fits
+    std::vector<int32_t> childLanes; // Gathered child sizes, min sizes and grow factors of a wide container, int16_t coordinates
+    std::vector<double> childLanesFloat; // The same for float coordinates
+    std::vector<int16_t> characterAdvances; // Advances of the text being truncated, int16_t coordinates
+    std::vector<int32_t> characterAdvances32; // The same for int32_t coordinates
+    std::vector<float> characterAdvancesFloat; // The same for float coordinates
+    std::vector<BasicComputedLayout<int16_t>> previousLayouts; // Layouts of the children of a container being placed again by layoutAppended, int16_t coordinates
+    std::vector<BasicComputedLayout<int32_t>> previousLayouts32; // The same for int32_t coordinates
+    std::vector<BasicComputedLayout<float>> previousLayoutsFloat; // The same for float coordinates
+    std::vector<uint32_t> polygonIndices; // Points of the polygon being triangulated that are not clipped yet
+
+    LayoutContext();
 };
 
 
 //This is the main function that does the layout stuff
-void layout(Container* container, BaseMeasurementContext* measurementContext);
+template<typename Coord>
+void layout(BasicContainer<Coord>* container, BasicMeasurementContext<Coord>* measurementContext);
+
+//Same as above but uses the scratch buffers in the layout context, use this for steady state layout
+template<typename Coord>
+void layout(BasicContainer<Coord>* container, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext);
+
+//The passes of a layout in the order they run
+enum LayoutPass : int8_t {
+    LayoutPassInit, // Resets the computed sizes
+    LayoutPassFitWidth,
+    LayoutPassGrowWidth,
+    LayoutPassWrap,
+    LayoutPassFitHeight,
+    LayoutPassGrowHeight,
+    LayoutPassPositions,
+    LayoutPassCount
+};
+
+//Same as layout but adds the time spent in each pass to passSeconds, for profiling
+template<typename Coord>
+void layoutProfiled(BasicContainer<Coord>* container, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext, 
+    double passSeconds[LayoutPassCount]);
+
+//Lays out children appended to a column container of an already layed out tree, like a new message at the end of 
+//a log. The children from firstNewChild on must be new and nothing else may have changed since the last layout. 
+//When the column keeps its width and its height follows its content, only the new children are layed out, they are 
+//placed after the previous last child and the new height is carried up through the ancestors. Where an ancestor is
+//a plain column whose height is exactly its content, before and after, only its children after the chain are moved 
+//down. Any other ancestor grows and places all of its children again and checks each one, so that part of the cost 
+//grows with the number of siblings along the chain. Otherwise the whole tree is layed out again. Returns true if the 
+//fast path was taken, either way the result is the same as layout() on the whole tree.
+template<typename Coord>
+bool layoutAppended(BasicContainer<Coord>* column, size_t firstNewChild, BasicMeasurementContext<Coord>* measurementContext, 
+    LayoutContext* layoutContext);
+
+//Min content width of an element of a layed out tree. The layout only computes layout.minWidth where a shrinking 
+//container needed it and leaves it LengthAuto everywhere else, this computes a missing one on demand, along with 
+//those of the subtree it depends on, and keeps it in the layout. The tree must be unchanged since its last layout.
+template<typename Coord>
+Coord resolveMinWidth(BasicBaseElement<Coord>* element, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext);
+
+//State of a time sliced layout job
+enum LayoutStatus : int8_t {
+    LayoutIncomplete = 0, // Ran out of budget, call run again to continue
+    LayoutComplete = 1, // Every pass is done and the tree holds the final layout
+    LayoutCancelled = 2, // Cancelled, nothing runs until restart is called
+    LayoutWaiting = 3 // Waiting on measurements, resolve the pending requests and call run again
+};
+
+//A layout split into small steps so a large tree can be layed out over several frames. The tree is flattened once 
+//and every pass keeps a cursor into it, run does as much work as the budget allows and returns where it stopped. 
+//The tree must not change while a job is running, call restart after changing it or cancel to drop the job. 
+//A finished job gives the same result as layout().
+template<typename Coord>
+class BasicLayoutJob {
+public:
+    BasicLayoutJob(BasicContainer<Coord>* root, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext);
+
+    //Runs until done or the budget is used up. The work budget counts elements visited and the time budget is 
+    //checked every few elements, a budget of 0 means no limit. Overshoot is at most one element's work.
+    LayoutStatus run(uint32_t workBudget, uint32_t timeBudgetMicroseconds);
+
+    //Starts over from the first pass, the flattened element list keeps its storage
+    void restart();
+
+    //Starts over from a pass, keeping the flattened tree and what the passes before it did. The tree must not have 
+    //changed since they ran. From LayoutPassInit, or before the tree was ever flattened, this is restart.
+    void restartFrom(LayoutPass pass);
+
+    //Stops the job, run does nothing until restart is called
+    void cancel();
+
+    LayoutStatus getStatus() const { return status; }
+
+    //The pass the job is in, LayoutPassCount once it is done
+    LayoutPass getPass() const { return (LayoutPass)pass; }
+
+private:
+    struct Frame {
+        BasicContainer<Coord>* container;
+        uint32_t nextChild;
+    };
+
+    BasicContainer<Coord>* root;
+    BasicMeasurementContext<Coord>* measurementContext;
+    LayoutContext* layoutContext;
+
+    std::vector<BasicBaseElement<Coord>*> elements; // The tree in pre-order, filled by the first pass
+    std::vector<Frame> stack; // Containers being flattened and the next child to visit in each
+    uint8_t pass; // The pass the cursor belongs to
+    size_t cursor; // Elements of the current pass already done
+    LayoutStatus status;
+
+    bool step();
+};
+
+typedef BasicLayoutJob<int16_t> LayoutJob;
+
+//A measurement the async layout is waiting on
+struct MeasurementRequest {
+    std::string text; // The text to measure, empty for a line height
+    uint8_t font;
+    int16_t lineSpacing; // Line spacing of a line height request
+    bool isLineHeight; // True for getLineHeight, false for measureTextWidth
+};
+
+//Layout against a measurement service that can't answer synchronously, like a font service in another process or 
+//a Web Worker. run lays the tree out with the measurements it already has and gathers every distinct one it is 
+//missing, the caller answers them all in one batch and calls run again. Missing text widths are estimated from the 
+//widths of the words and spaces in them so the wrap pass asks for the lines it will most likely end up with, and 
+//missing line heights from the tallest font already known. The first batch holds the text, word and line height 
+//measurements and the second the wrapped lines, so a cold layout usually takes 3 runs. Fonts whose widths don't add 
+//up from their words take more, 4 was the most seen on a random corpus. A round resumes at the first pass that had 
+//to estimate and keeps the passes before it, so the tree must not change until run returns LayoutComplete, the run 
+//after that starts over. The result is then the same as layout() with a context giving the same answers. Answers 
+//are kept for later layouts until clearCache.
+template<typename Coord>
+class BasicAsyncLayout : public BasicMeasurementContext<Coord> {
+public:
+    BasicAsyncLayout(BasicContainer<Coord>* root, LayoutContext* layoutContext);
+
+    //Runs a round, returns LayoutComplete or LayoutWaiting with the requests in getPendingRequests
+    LayoutStatus run();
+
+    //Every distinct measurement the last round was missing, in the order they were first needed
+    const std::vector<MeasurementRequest>& getPendingRequests() const { return pendingRequests; }
+
+    //Answers a pending request by its index, unanswered requests are asked for again by the next round
+    void resolveRequest(size_t index, Coord result);
+
+    //Answers every pending request from a synchronous context, for tests and in process services
+    void resolveWith(BasicMeasurementContext<Coord>* measurementContext);
+
+    //Forgets every answer, use when the fonts change
+    void clearCache();
+
+    //Answers from the cache during a round, these are called by the layout passes
+    Coord measureTextWidth(std::string& str, uint8_t font) override;
+    Coord getLineHeight(int16_t lineSpacing, uint8_t font) override;
+
+private:
+    BasicContainer<Coord>* root;
+    LayoutContext* layoutContext;
+    BasicLayoutJob<Coord> job; // The layout, kept between the rounds so a round resumes where the last one estimated
+    LayoutPass resumePass; // Pass the next round starts from
+    LayoutPass missedPass; // First pass of this round that had to estimate, LayoutPassCount if none did
+
+    std::unordered_map<std::string, Coord> textWidths; // Answered widths, keyed by the font byte followed by the text
+    std::unordered_map<uint32_t, Coord> lineHeights; // Answered line heights, keyed by line spacing and font
+    std::unordered_map<std::string, uint32_t> pendingWidths; // Index of each missing width in the pending requests
+    std::unordered_map<uint32_t, uint32_t> pendingLineHeights; // The same for line heights
+    std::vector<MeasurementRequest> pendingRequests;
+    std::string key; // Scratch for building cache keys
+
+    bool lookupWidth(const char* str, size_t length, uint8_t font, Coord& width);
+};
+
+typedef BasicAsyncLayout<int16_t> AsyncLayout;
+
+//Threads that run one job on every worker at once, shared by the measurement pool, the breakpoint layout and the
+//tile rasterizer. Internal to the engine. The calling thread is worker 0 and takes part in every run.
+class WorkerPool {
+public:
+    explicit WorkerPool(int threadCount);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int getWorkerCount() const { return workerCount; }
+
+    //Calls job(worker) once for each worker index and returns once every call has returned, what the calls wrote is
+    //visible to the caller then. Runs are not reentrant, only one thread may call run at a time.
+    template<typename Job>
+    void run(Job& job) { runJob(&callJob<Job>, &job); }
+
+private:
+    int workerCount;
+    std::vector<std::thread> threads; // One per worker after the first
+    void (*job)(void* data, int worker); // The current job
+    void* jobData;
+
+    std::mutex mutex;
+    std::condition_variable workReady;
+    std::condition_variable workDone;
+    uint32_t generation; // Bumped for every run, wakes the threads
+    int busyWorkers; // Threads still running the current job
+    bool stopping;
+
+    template<typename Job>
+    static void callJob(void* job, int worker) { (*(Job*)job)(worker); }
+
+    void runJob(void (*job)(void* data, int worker), void* data);
+    void workerLoop(int worker);
+};
+
+//Optional prepass that measures every text element of a tree in parallel before layout. Each text is split into 
+//words and measured on one of the pool's threads, the results are stored on the text and the next layout uses them 
+//instead of measuring again. The threads and their measurement contexts live as long as the pool.
+template<typename Coord>
+class BasicTextMeasurementPool {
+public:
+    BasicTextMeasurementPool(BasicMeasurementContextFactory<Coord>* factory, int threadCount);
+    ~BasicTextMeasurementPool();
+
+    //Measures the text elements under the container, the calling thread takes part and returns once all are done
+    void measure(BasicContainer<Coord>* container);
+
+private:
+    struct Worker {
+        BasicMeasurementContext<Coord>* measurementContext;
+        std::vector<TextSpan> words; // Word spans of the text being measured
+        std::string word; // The current word, copied out so it can be measured
+    };
+
+    BasicMeasurementContextFactory<Coord>* factory;
+    std::vector<Worker> workers;
+    std::vector<BasicText<Coord>*> texts; // The text elements of the tree being measured
+    std::atomic<size_t> nextText; // Index of the next batch of texts to hand out
+    WorkerPool pool; // Last so its threads stop before the rest is destroyed
+};
+
+typedef BasicTextMeasurementPool<int16_t> TextMeasurementPool;
+
+//Lays the same tree out at several root widths in one call, for responsive previews and exports. The work that 
+//doesn't depend on the width, splitting and measuring the text and fitting the widths, is done once on the tree. 
+//The widths are then spread over the threads. The first width is layed out on the tree itself, so the call leaves 
+//it as layout() would with the root that wide, the root's own width is left as it was. Each thread lays the other 
+//widths out one after the other on its own copy of the tree, made once per call and started again from the shared 
+//fit for every width. The results are the computed layouts and the wrapped lines of every element for each width, 
+//kept in arrays in the order of getElement until the next call.
+template<typename Coord>
+class BasicBreakpointLayout {
+public:
+    BasicBreakpointLayout(BasicMeasurementContextFactory<Coord>* factory, int threadCount);
+    ~BasicBreakpointLayout();
+    BasicBreakpointLayout(const BasicBreakpointLayout&) = delete;
+    BasicBreakpointLayout& operator=(const BasicBreakpointLayout&) = delete;
+
+    //Lays the tree out once for each root width, the calling thread takes part and returns once all are done
+    void layout(BasicContainer<Coord>* root, const Coord* widths, size_t widthCount);
+
+    //The results of the last call, one per width in the order the widths were given
+    size_t getResultCount() const;
+    Coord getResultWidth(size_t index) const;
+
+    //The elements of the tree of the last call in pre-order, the root is element 0. Only valid while that tree is.
+    size_t getElementCount() const;
+    BasicBaseElement<Coord>* getElement(size_t element) const;
+
+    //The computed layout of an element at a width
+    const BasicComputedLayout<Coord>& getLayout(size_t index, size_t element) const;
+
+    //The wrapped lines of a text element at a width, as they are shown so a truncated last line ends in the
+    //ellipsis. Lines are not null terminated, length is set to their number of characters.
+    uint32_t getLineCount(size_t index, size_t element) const;
+    const char* getLine(size_t index, size_t element, uint32_t line, uint32_t* length) const;
+
+private:
+    struct Worker {
+        BasicMeasurementContext<Coord>* measurementContext;
+        LayoutContext layoutContext;
+        BasicContainer<Coord>* copy; // Copy of the tree the widths after the first are layed out on, or nullptr
+        std::vector<BasicBaseElement<Coord>*> elements; // The copy's elements, in the same order as the tree's
+    };
+
+    struct Result {
+        Coord width;
+        std::vector<BasicComputedLayout<Coord>> layouts; // One per element
+        std::vector<uint32_t> firstLines; // Each element's first line in lines, one more than the elements
+        std::vector<TextSpan> lines; // Wrapped lines, into text
+        std::string text;
+    };
+
+    BasicMeasurementContextFactory<Coord>* factory;
+    std::vector<Worker> workers;
+    BasicContainer<Coord>* root; // The tree of the current call
+    Coord rootWidth; // The root's own width, put back once the tree is layed out
+    std::vector<BasicBaseElement<Coord>*> elements; // The tree's elements in pre-order
+    std::vector<BasicText<Coord>*> texts; // The text elements of the tree
+    std::vector<BasicComputedLayout<Coord>> fitLayouts; // The layout of each element after the shared fit
+    std::vector<Result> results; // Only the first resultCount are in use, the rest keep their storage
+    size_t resultCount;
+    std::atomic<size_t> nextItem; // Next batch of texts or next width to hand out
+    WorkerPool pool; // Last so its threads stop before the rest is destroyed
+
+    void copyTree(Worker* worker);
+    void layoutWidths(Worker* worker);
+    void layoutWidth(Worker* worker, size_t index);
+};
+
+typedef BasicBreakpointLayout<int16_t> BreakpointLayout;
+
+//Deletes an element and everything under it, elements are created with new and containers don't own their children
+template<typename Coord>
+void destroyElement(BasicBaseElement<Coord>* element);
+
+//Paginated layout for a root column container. Children are pulled from the stream and layed out into pages of 
+//pageHeight, using the page's width and style. Text that doesn't fit is split at its wrapped line boundaries and 
+//continues on the next page, with the whitespace of the text kept as it was. Each child is layed out once on its own,
+//when the page has a set width and no child grows the children are moved into place and the page isn't layed out 
+//again. The page container is reused for every page and must start empty. 
+//Returns the number of pages produced, peak memory is proportional to one page rather than the whole document.
+template<typename Coord>
+int layoutPaginated(BasicContainer<Coord>* page, Coord pageHeight, BasicPageStream<Coord>* stream, 
+    BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext);
+
+//Test hook, lays out the tree once to warm up the context and then again while counting heap allocations. 
+//Returns the number of allocations made by the second call, anything other than 0 is a failure. 
+//Only available when tinyLayoutEngineAllocationAudit.cpp is linked in, it replaces the global allocator.
+size_t auditLayoutAllocations(Container* container, BaseMeasurementContext* measurementContext, LayoutContext* layoutContext);
 
 
 } // namespace TinyLayoutEngine
@@ -0,0 +1,87 @@
+//Allocation audit for the layout engine. This is only linked into test builds, it replaces the global 
+//allocator with one that counts allocations while an audit is running.
+
+#include "tinyLayoutEngine.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<bool> auditing(false);
+std::atomic<size_t> allocationCount(0);
+
+void countAllocation() {
+    if(auditing.load(std::memory_order_relaxed)) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void* countedAlloc(size_t size) {
+    countAllocation();
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+
+//aligned_alloc wants the size to be a multiple of the alignment, the block is still released with free
+void* countedAlignedAlloc(size_t size, std::align_val_t alignment) {
+    countAllocation();
+    size_t align = (size_t)alignment < sizeof(void*) ? sizeof(void*) : (size_t)alignment;
+    size_t rounded = size == 0 ? align : (size + align - 1) / align * align;
+    void* p = std::aligned_alloc(align, rounded);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+
+} // namespace
+
+//every form of the global allocator is replaced so nothing the engine allocates slips past the count
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try { return countedAlloc(size); } catch(const std::bad_alloc&) { return nullptr; }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try { return countedAlloc(size); } catch(const std::bad_alloc&) { return nullptr; }
+}
+void* operator new(size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try { return countedAlignedAlloc(size, alignment); } catch(const std::bad_alloc&) { return nullptr; }
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try { return countedAlignedAlloc(size, alignment); } catch(const std::bad_alloc&) { return nullptr; }
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+
+namespace TinyLayoutEngine {
+
+size_t auditLayoutAllocations(Container* container, BaseMeasurementContext* measurementContext, LayoutContext* layoutContext) {
+    
+    //warm up, this is allowed to grow the scratch buffers and the wrapped lines
+    layout(container, measurementContext, layoutContext);
+
+    //now the audited call, the tree shape is the same so nothing should be allocated
+    allocationCount.store(0);
+    auditing.store(true);
+    layout(container, measurementContext, layoutContext);
+    auditing.store(false);
+
+    return allocationCount.load();
+}
+
+} // namespace TinyLayoutEngine
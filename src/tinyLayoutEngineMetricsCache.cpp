@@ -0,0 +1,356 @@
+//Persistent text metrics cache. The file is a header, a hash index of bucket heads and the entries appended one after
+//the other. Every entry is checked against its checksum before it is trusted. An append writes the entry, then 
+//publishes the new used size and only then links the entry into its bucket, so a process killed half way through an 
+//append leaves at worst an unreachable entry. The header checksum only covers the fields that never change after the
+//file is created, the used size and entry count are checked against the file instead.
+
+#include "tinyLayoutEngineMetricsCache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace TinyLayoutEngine {
+
+namespace {
+
+const char MetricsCacheMagic[8] = {'T', 'L', 'E', 'M', 'E', 'T', 'R', 'C'};
+const uint32_t MetricsCacheVersion = 2; // Bump whenever the layout of the file changes
+
+struct MetricsCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t bucketCount; // Size of the hash index, a power of two
+    uint64_t fontSetFingerprint;
+    uint32_t checksum; // Over the fields above, which are fixed when the file is created
+    uint32_t entryCount;
+    uint64_t usedSize; // Bytes of the file in use, the rest is room for appending
+};
+
+struct MetricsCacheEntry {
+    uint32_t next; // Offset of the next entry in the bucket, 0 at the end
+    uint32_t hash;
+    uint32_t textLength; // The text follows the entry
+    uint32_t checksum; // Over the fields below and the text
+    double value;
+    int16_t lineSpacing;
+    uint8_t font;
+    uint8_t isLineHeight;
+    uint32_t padding;
+};
+
+const size_t MetricsCacheIndexOffset = sizeof(MetricsCacheHeader);
+const size_t MetricsCacheMinimumGrowth = 64 * 1024;
+
+//FNV-1a
+uint32_t hashBytes(uint32_t hash, const void* bytes, size_t length) {
+    const uint8_t* p = (const uint8_t*)bytes;
+    for(size_t i = 0; i < length; i++) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+uint32_t hashKey(const char* text, uint32_t length, uint8_t font, int16_t lineSpacing, bool isLineHeight) {
+    uint32_t hash = 2166136261u;
+    uint8_t kind = isLineHeight ? 1 : 0;
+    hash = hashBytes(hash, &kind, 1);
+    hash = hashBytes(hash, &font, 1);
+    hash = hashBytes(hash, &lineSpacing, sizeof(lineSpacing));
+    return hashBytes(hash, text, length);
+}
+
+uint32_t headerChecksum(const MetricsCacheHeader* header) {
+    return hashBytes(2166136261u, header, offsetof(MetricsCacheHeader, checksum));
+}
+
+uint32_t entryChecksum(const MetricsCacheEntry* entry) {
+    uint32_t hash = hashBytes(2166136261u, &entry->hash, sizeof(entry->hash));
+    hash = hashBytes(hash, &entry->textLength, sizeof(entry->textLength));
+    hash = hashBytes(hash, &entry->value, offsetof(MetricsCacheEntry, padding) - offsetof(MetricsCacheEntry, value));
+    return hashBytes(hash, (const char*)(entry + 1), entry->textLength);
+}
+
+//entries are kept 8 byte aligned for the value
+size_t entrySize(uint32_t textLength) {
+    return (sizeof(MetricsCacheEntry) + textLength + 7) & ~(size_t)7;
+}
+
+} // namespace
+
+template<typename Coord>
+BasicMetricsCacheContext<Coord>::BasicMetricsCacheContext(const char* path, uint64_t fontSetFingerprint,
+    BasicMeasurementContext<Coord>* measurementContext, uint32_t bucketCount, size_t maxFileSize) {
+
+    this->measurementContext = measurementContext;
+    this->fontSetFingerprint = fontSetFingerprint;
+    this->maxFileSize = (std::min)(maxFileSize, (size_t)UINT32_MAX);
+    data = nullptr;
+    mappedSize = 0;
+
+    //round the index up to a power of two so a bucket is picked with a mask
+    uint32_t buckets = 1;
+    while(buckets < bucketCount && buckets < (1u << 24)) {
+        buckets <<= 1;
+    }
+
+    fileDescriptor = open(path, O_RDWR | O_CREAT, 0644);
+    if(fileDescriptor < 0) {
+        return;
+    }
+
+    //another process has the file, starting it over would pull the mapping from under that one
+    if(flock(fileDescriptor, LOCK_EX | LOCK_NB) != 0) {
+        close(fileDescriptor);
+        fileDescriptor = -1;
+        return;
+    }
+
+    struct stat fileStat;
+    if(fstat(fileDescriptor, &fileStat) != 0) {
+        return;
+    }
+
+    //a file that doesn't check out is ignored and started over
+    size_t fileSize = (size_t)fileStat.st_size;
+    if(fileSize < sizeof(MetricsCacheHeader) || !mapFile(fileSize) || !validateFile(fontSetFingerprint, fileSize)) {
+        resetFile(fontSetFingerprint, buckets);
+    }
+}
+
+template<typename Coord>
+BasicMetricsCacheContext<Coord>::~BasicMetricsCacheContext() {
+    sync();
+    if(data != nullptr) {
+        munmap(data, mappedSize);
+    }
+    if(fileDescriptor >= 0) {
+        close(fileDescriptor);
+    }
+}
+
+template<typename Coord>
+uint32_t BasicMetricsCacheContext<Coord>::getEntryCount() const {
+    return data != nullptr ? ((const MetricsCacheHeader*)data)->entryCount : 0;
+}
+
+template<typename Coord>
+void BasicMetricsCacheContext<Coord>::sync() {
+    if(data != nullptr) {
+        msync(data, mappedSize, MS_SYNC);
+    }
+}
+
+template<typename Coord>
+bool BasicMetricsCacheContext<Coord>::mapFile(size_t size) {
+    if(data != nullptr) {
+        munmap(data, mappedSize);
+        data = nullptr;
+        mappedSize = 0;
+    }
+
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    if(mapped == MAP_FAILED) {
+        return false;
+    }
+
+    data = (uint8_t*)mapped;
+    mappedSize = size;
+    return true;
+}
+
+template<typename Coord>
+bool BasicMetricsCacheContext<Coord>::resetFile(uint64_t fontSetFingerprint, uint32_t bucketCount) {
+    size_t usedSize = MetricsCacheIndexOffset + (size_t)bucketCount * sizeof(uint32_t);
+    size_t fileSize = (std::max)((std::min)(usedSize + MetricsCacheMinimumGrowth, maxFileSize), usedSize);
+
+    //truncating to 0 first zeroes the index
+    if(ftruncate(fileDescriptor, 0) != 0 || ftruncate(fileDescriptor, (off_t)fileSize) != 0 || !mapFile(fileSize)) {
+        if(data != nullptr) {
+            munmap(data, mappedSize);
+            data = nullptr;
+        }
+        return false;
+    }
+
+    MetricsCacheHeader* header = (MetricsCacheHeader*)data;
+    memcpy(header->magic, MetricsCacheMagic, sizeof(MetricsCacheMagic));
+    header->version = MetricsCacheVersion;
+    header->bucketCount = bucketCount;
+    header->fontSetFingerprint = fontSetFingerprint;
+    header->usedSize = usedSize;
+    header->entryCount = 0;
+    header->checksum = headerChecksum(header);
+    return true;
+}
+
+template<typename Coord>
+bool BasicMetricsCacheContext<Coord>::validateFile(uint64_t fontSetFingerprint, size_t fileSize) {
+    const MetricsCacheHeader* header = (const MetricsCacheHeader*)data;
+
+    if(memcmp(header->magic, MetricsCacheMagic, sizeof(MetricsCacheMagic)) != 0 || header->version != MetricsCacheVersion ||
+        header->checksum != headerChecksum(header) || header->fontSetFingerprint != fontSetFingerprint) {
+        return false;
+    }
+
+    uint32_t bucketCount = header->bucketCount;
+    if(bucketCount == 0 || (bucketCount & (bucketCount - 1)) != 0) {
+        return false;
+    }
+
+    size_t indexEnd = MetricsCacheIndexOffset + (size_t)bucketCount * sizeof(uint32_t);
+    return header->usedSize >= indexEnd && header->usedSize <= fileSize;
+}
+
+//Walks the bucket of the key, an entry out of bounds or with a bad checksum ends the walk as a miss
+template<typename Coord>
+bool BasicMetricsCacheContext<Coord>::lookup(const char* text, uint32_t length, uint8_t font, int16_t lineSpacing,
+    bool isLineHeight, double& value) {
+
+    if(data == nullptr) {
+        return false;
+    }
+
+    const MetricsCacheHeader* header = (const MetricsCacheHeader*)data;
+    const uint32_t* index = (const uint32_t*)(data + MetricsCacheIndexOffset);
+    uint32_t hash = hashKey(text, length, font, lineSpacing, isLineHeight);
+    size_t indexEnd = MetricsCacheIndexOffset + (size_t)header->bucketCount * sizeof(uint32_t);
+
+    uint32_t offset = index[hash & (header->bucketCount - 1)];
+    while(offset != 0) {
+        if(offset < indexEnd || offset + sizeof(MetricsCacheEntry) > header->usedSize) {
+            return false;
+        }
+
+        const MetricsCacheEntry* entry = (const MetricsCacheEntry*)(data + offset);
+        if(offset + entrySize(entry->textLength) > header->usedSize || entry->checksum != entryChecksum(entry)) {
+            return false;
+        }
+
+        if(entry->hash == hash && entry->textLength == length && entry->font == font && entry->lineSpacing == lineSpacing &&
+            entry->isLineHeight == (isLineHeight ? 1 : 0) && memcmp(entry + 1, text, length) == 0) {
+            value = entry->value;
+            return true;
+        }
+
+        //entries only ever link back to older ones, anything else is a damaged chain
+        if(entry->next >= offset) {
+            return false;
+        }
+        offset = entry->next;
+    }
+
+    return false;
+}
+
+template<typename Coord>
+void BasicMetricsCacheContext<Coord>::append(const char* text, uint32_t length, uint8_t font, int16_t lineSpacing,
+    bool isLineHeight, double value) {
+
+    if(data == nullptr) {
+        return;
+    }
+
+    //a full file is started over, that keeps the entries of the measurements made since. Offsets are 32 bit so 
+    //the cap is at most 4GB
+    size_t usedSize = ((const MetricsCacheHeader*)data)->usedSize;
+    size_t size = entrySize(length);
+    if(usedSize + size > maxFileSize) {
+        uint32_t bucketCount = ((const MetricsCacheHeader*)data)->bucketCount;
+        if(!resetFile(fontSetFingerprint, bucketCount)) {
+            return;
+        }
+        usedSize = ((const MetricsCacheHeader*)data)->usedSize;
+        if(usedSize + size > maxFileSize) {
+            return;
+        }
+    }
+
+    //grow the file when the entry doesn't fit
+    if(usedSize + size > mappedSize) {
+        size_t newSize = (std::max)(mappedSize * 2, usedSize + size + MetricsCacheMinimumGrowth);
+        newSize = (std::max)((std::min)(newSize, maxFileSize), usedSize + size);
+        if(ftruncate(fileDescriptor, (off_t)newSize) != 0 || !mapFile(newSize)) {
+            return;
+        }
+    }
+
+    MetricsCacheHeader* header = (MetricsCacheHeader*)data;
+    uint32_t* index = (uint32_t*)(data + MetricsCacheIndexOffset);
+    uint32_t hash = hashKey(text, length, font, lineSpacing, isLineHeight);
+    uint32_t& bucket = index[hash & (header->bucketCount - 1)];
+
+    //write the entry first, then publish the new size and link it last. The fences keep the compiler from reordering
+    //the stores, the mapping keeps them in the file even when the process is killed.
+    MetricsCacheEntry* entry = (MetricsCacheEntry*)(data + usedSize);
+    memset(entry, 0, size);
+    entry->next = bucket < usedSize ? bucket : 0;
+    entry->hash = hash;
+    entry->textLength = length;
+    entry->value = value;
+    entry->lineSpacing = lineSpacing;
+    entry->font = font;
+    entry->isLineHeight = isLineHeight ? 1 : 0;
+    memcpy(entry + 1, text, length);
+    entry->checksum = entryChecksum(entry);
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+
+    header->usedSize = usedSize + size;
+    header->entryCount++;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+
+    bucket = (uint32_t)usedSize;
+}
+
+template<typename Coord>
+Coord BasicMetricsCacheContext<Coord>::measureTextWidth(std::string& str, uint8_t font) {
+    double value = 0;
+    if(lookup(str.data(), (uint32_t)str.size(), font, 0, false, value)) {
+        return (Coord)value;
+    }
+
+    Coord width = measurementContext->measureTextWidth(str, font);
+    append(str.data(), (uint32_t)str.size(), font, 0, false, (double)width);
+    return width;
+}
+
+template<typename Coord>
+Coord BasicMetricsCacheContext<Coord>::measureTextSpanWidth(const char* str, size_t length, uint8_t font) {
+    double value = 0;
+    if(lookup(str, (uint32_t)length, font, 0, false, value)) {
+        return (Coord)value;
+    }
+
+    Coord width = measurementContext->measureTextSpanWidth(str, length, font);
+    append(str, (uint32_t)length, font, 0, false, (double)width);
+    return width;
+}
+
+template<typename Coord>
+bool BasicMetricsCacheContext<Coord>::measureTextAdvances(const char* str, size_t length, uint8_t font, Coord* advances) {
+    return measurementContext->measureTextAdvances(str, length, font, advances);
+}
+
+template<typename Coord>
+Coord BasicMetricsCacheContext<Coord>::getLineHeight(int16_t lineSpacing, uint8_t font) {
+    double value = 0;
+    if(lookup("", 0, font, lineSpacing, true, value)) {
+        return (Coord)value;
+    }
+
+    Coord lineHeight = measurementContext->getLineHeight(lineSpacing, font);
+    append("", 0, font, lineSpacing, true, (double)lineHeight);
+    return lineHeight;
+}
+
+template class BasicMetricsCacheContext<int16_t>;
+template class BasicMetricsCacheContext<int32_t>;
+template class BasicMetricsCacheContext<float>;
+
+} // namespace TinyLayoutEngine
\ No newline at end of file
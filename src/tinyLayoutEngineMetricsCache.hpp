@@ -0,0 +1,68 @@
+#ifndef TINY_LAYOUT_ENGINE_METRICS_CACHE_HPP
+#define TINY_LAYOUT_ENGINE_METRICS_CACHE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+#include "tinyLayoutEngine.hpp"
+
+namespace TinyLayoutEngine {
+
+const size_t DefaultMetricsCacheMaxSize = 64 * 1024 * 1024;
+
+//A measurement context backed by a memory mapped cache file, so a restarted process starts with every text width
+//and line height its previous runs measured. Lookups read the mapped file directly, nothing is parsed on open.
+//Measurements that miss are forwarded to the wrapped context and appended to the file.
+//The file is keyed by a fingerprint of the font set, a file made for other fonts, by another version of the
+//format or that fails its checksums is discarded and started over. Only one process uses a file at a time, it is
+//locked while open and a context that finds it locked by another process runs without it, see isOpen.
+//The wrap pass measures every line it tries, so the file can grow quickly. Once an append would take it past
+//maxFileSize it is started over, so it holds what the recent runs measured and its size stays bounded.
+//The context isn't thread safe, it must only be used by one thread at a time, so it can't back a measurement pool.
+//Native builds only, it needs mmap.
+template<typename Coord>
+class BasicMetricsCacheContext : public BasicMeasurementContext<Coord> {
+public:
+
+    //Opens or creates the cache file, bucketCount is the size of the hash index of a new file
+    BasicMetricsCacheContext(const char* path, uint64_t fontSetFingerprint, BasicMeasurementContext<Coord>* measurementContext,
+        uint32_t bucketCount = 4096, size_t maxFileSize = DefaultMetricsCacheMaxSize);
+    ~BasicMetricsCacheContext();
+
+    //False when the file couldn't be opened, locked or mapped, measurements then go straight to the wrapped context
+    bool isOpen() const { return data != nullptr; }
+
+    //Number of measurements stored in the file
+    uint32_t getEntryCount() const;
+
+    //Flushes the appended measurements to disk, they are also flushed when the context is destroyed
+    void sync();
+
+    Coord measureTextWidth(std::string& str, uint8_t font) override;
+    Coord measureTextSpanWidth(const char* str, size_t length, uint8_t font) override;
+    Coord getLineHeight(int16_t lineSpacing, uint8_t font) override;
+
+    //Not cached, a label's advances are asked for once per truncation and are as long as its text
+    bool measureTextAdvances(const char* str, size_t length, uint8_t font, Coord* advances) override;
+
+private:
+    BasicMeasurementContext<Coord>* measurementContext;
+    uint64_t fontSetFingerprint;
+    size_t maxFileSize;
+    int fileDescriptor;
+    uint8_t* data; // The mapped file
+    size_t mappedSize;
+
+    bool mapFile(size_t size);
+    bool resetFile(uint64_t fontSetFingerprint, uint32_t bucketCount);
+    bool validateFile(uint64_t fontSetFingerprint, size_t fileSize);
+    bool lookup(const char* text, uint32_t length, uint8_t font, int16_t lineSpacing, bool isLineHeight, double& value);
+    void append(const char* text, uint32_t length, uint8_t font, int16_t lineSpacing, bool isLineHeight, double value);
+};
+
+typedef BasicMetricsCacheContext<int16_t> MetricsCacheContext;
+
+} // namespace TinyLayoutEngine
+
+#endif // TINY_LAYOUT_ENGINE_METRICS_CACHE_HPP
\ No newline at end of file
@@ -0,0 +1,546 @@
+//Tile based software rasterizer. Everything is done in integers, positions in sixteenths of a pixel and coverage
+//from 16 samples per pixel, so the image doesn't depend on the compiler's floating point either.
+
+#include "tinyLayoutEngineRaster.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace TinyLayoutEngine {
+
+namespace {
+
+const int64_t Subpixels = 16; // Positions are kept in sixteenths of a pixel
+const int SampleCount = 16; // 4 by 4 samples per pixel
+const int64_t SampleOffsets[4] = {2, 6, 10, 14}; // Sample positions inside a pixel, in sixteenths
+
+template<typename Coord>
+int64_t toSubpixels(Coord value) {
+    if(std::numeric_limits<Coord>::is_integer) {
+        return (int64_t)value * Subpixels;
+    }
+    return (int64_t)std::floor((double)value * Subpixels + 0.5);
+}
+
+int64_t floorDivide(int64_t value, int64_t divisor) {
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+int clampToInt(int64_t value, int low, int high) {
+    return (int)(std::max)((int64_t)low, (std::min)((int64_t)high, value));
+}
+
+uint32_t multiply255(uint32_t a, uint32_t b) {
+    uint32_t product = a * b + 128;
+    return (product + (product >> 8)) >> 8;
+}
+
+//A rectangle with round corners, in subpixels
+struct RoundedBox {
+    int64_t left;
+    int64_t top;
+    int64_t right;
+    int64_t bottom;
+    int64_t radius;
+};
+
+bool containsSample(const RoundedBox& box, int64_t x, int64_t y) {
+    if(x < box.left || x >= box.right || y < box.top || y >= box.bottom) {
+        return false;
+    }
+
+    //only samples in a corner square have to be tested against the circle
+    int64_t dx = x < box.left + box.radius ? box.left + box.radius - x : x >= box.right - box.radius ? x - (box.right - box.radius) : 0;
+    int64_t dy = y < box.top + box.radius ? box.top + box.radius - y : y >= box.bottom - box.radius ? y - (box.bottom - box.radius) : 0;
+    return dx == 0 || dy == 0 || dx * dx + dy * dy <= box.radius * box.radius;
+}
+
+//samples of the pixel inside the box, pixels well inside or outside are answered without sampling
+int countSamples(const RoundedBox& box, int px, int py) {
+    int64_t left = (int64_t)px * Subpixels;
+    int64_t top = (int64_t)py * Subpixels;
+    int64_t right = left + Subpixels;
+    int64_t bottom = top + Subpixels;
+
+    if(right <= box.left || left >= box.right || bottom <= box.top || top >= box.bottom) {
+        return 0;
+    }
+    bool insideX = left >= box.left && right <= box.right;
+    bool insideY = top >= box.top && bottom <= box.bottom;
+    if(insideX && insideY && ((left >= box.left + box.radius && right <= box.right - box.radius) ||
+        (top >= box.top + box.radius && bottom <= box.bottom - box.radius))) {
+        return SampleCount;
+    }
+
+    int count = 0;
+    for(int sy = 0; sy < 4; sy++) {
+        for(int sx = 0; sx < 4; sx++) {
+            count += containsSample(box, left + SampleOffsets[sx], top + SampleOffsets[sy]) ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+uint32_t samplesToCoverage(int count) {
+    return (uint32_t)((count * 255 + SampleCount / 2) / SampleCount);
+}
+
+//Number of samples set in a pixel's sample mask
+int countSampleBits(uint16_t samples) {
+    int count = 0;
+    for(; samples != 0; samples &= (uint16_t)(samples - 1)) {
+        count++;
+    }
+    return count;
+}
+
+//Edge of a triangle, a sample exactly on an edge belongs to only one of the two triangles sharing it
+struct Edge {
+    int64_t x;
+    int64_t y;
+    int64_t dx;
+    int64_t dy;
+    bool inclusive;
+
+    Edge(int64_t x0, int64_t y0, int64_t x1, int64_t y1) {
+        x = x0;
+        y = y0;
+        dx = x1 - x0;
+        dy = y1 - y0;
+        inclusive = dy < 0 || (dy == 0 && dx > 0);
+    }
+
+    bool inside(int64_t px, int64_t py) const {
+        int64_t w = dx * (py - y) - dy * (px - x);
+        return w > 0 || (w == 0 && inclusive);
+    }
+};
+
+} // namespace
+
+void blendPixel(const RasterTarget& target, int x, int y, Color color, uint32_t coverage) {
+    if(x < target.clipLeft || x >= target.clipRight || y < target.clipTop || y >= target.clipBottom) {
+        return;
+    }
+
+    uint32_t alpha = multiply255(color.a, coverage);
+    if(alpha == 0) {
+        return;
+    }
+    uint8_t* pixel = target.pixels + (size_t)y * target.stride + (size_t)x * 4;
+    uint32_t inverse = 255 - alpha;
+    pixel[0] = (uint8_t)(multiply255(color.r, alpha) + multiply255(pixel[0], inverse));
+    pixel[1] = (uint8_t)(multiply255(color.g, alpha) + multiply255(pixel[1], inverse));
+    pixel[2] = (uint8_t)(multiply255(color.b, alpha) + multiply255(pixel[2], inverse));
+    pixel[3] = (uint8_t)(alpha + multiply255(pixel[3], inverse));
+}
+
+template<typename Coord>
+BasicTileRasterizer<Coord>::BasicTileRasterizer(int threadCount, int tileSize) : pool(threadCount) {
+    this->tileSize = tileSize > 8 ? tileSize : 8;
+    pixels = nullptr;
+    width = 0;
+    height = 0;
+    stride = 0;
+    tileColumns = 0;
+    tileCount = 0;
+    clearColor = {0, 0, 0, 0};
+    glyphBlitter = nullptr;
+    nextTile = 0;
+
+    workers.resize(pool.getWorkerCount());
+    for(size_t i = 0; i < workers.size(); i++) {
+        workers[i].coverage.resize((size_t)this->tileSize * this->tileSize);
+    }
+}
+
+template<typename Coord>
+void BasicTileRasterizer<Coord>::draw(BasicContainer<Coord>* root, uint8_t* pixels, int width, int height, int stride,
+    Color clearColor, BasicGlyphBlitter<Coord>* glyphBlitter) {
+
+    this->pixels = pixels;
+    this->width = width;
+    this->height = height;
+    this->stride = stride;
+    this->clearColor = clearColor;
+    this->glyphBlitter = glyphBlitter;
+    if(width <= 0 || height <= 0) {
+        return;
+    }
+
+    //the primitives are gathered and binned on the calling thread, the tiles are drawn by all of them
+    primitives.clear();
+    int clip[4] = {0, 0, width, height};
+    collectPrimitives(root, clip);
+    binPrimitives();
+    nextTile = 0;
+
+    auto drawJob = [this](int worker) {
+        drawTiles(&workers[worker]);
+    };
+    pool.run(drawJob);
+}
+
+//
+//Primitives, the tree is walked once in paint order
+//
+
+template<typename Coord>
+void BasicTileRasterizer<Coord>::addPrimitive(const Primitive& primitive, const int clip[4], int64_t left, int64_t top, 
+    int64_t right, int64_t bottom) {
+
+    //the pixels touched by the bounds, inside the clip
+    int clipLeft = clampToInt(floorDivide(left, Subpixels), clip[0], clip[2]);
+    int clipTop = clampToInt(floorDivide(top, Subpixels), clip[1], clip[3]);
+    int clipRight = clampToInt(floorDivide(right + Subpixels - 1, Subpixels), clip[0], clip[2]);
+    int clipBottom = clampToInt(floorDivide(bottom + Subpixels - 1, Subpixels), clip[1], clip[3]);
+    if(clipLeft >= clipRight || clipTop >= clipBottom) {
+        return;
+    }
+
+    primitives.push_back(primitive);
+    Primitive& added = primitives.back();
+    added.clip[0] = clipLeft;
+    added.clip[1] = clipTop;
+    added.clip[2] = clipRight;
+    added.clip[3] = clipBottom;
+}
+
+template<typename Coord>
+void BasicTileRasterizer<Coord>::collectPrimitives(BasicBaseElement<Coord>* element, const int clip[4]) {
+
+    if(!element->displayed || !element->visible) {
+        return;
+    }
+
+    const BasicStyle<Coord>* style = getStyle<Coord>(element->style);
+    int64_t left = toSubpixels(element->layout.x);
+    int64_t top = toSubpixels(element->layout.y);
+    int64_t right = left + toSubpixels(element->layout.width);
+    int64_t bottom = top + toSubpixels(element->layout.height);
+    int64_t borderWidth = toSubpixels(style->borderWidth);
+
+    Primitive primitive = {};
+
+    //a polygon uses the style's colors for its fill and stroke instead of a box
+    if(element->elementType == ElementTypePolygon) {
+        BasicPolygon<Coord>* polygon = (BasicPolygon<Coord>*)element;
+        primitive.type = PrimitiveTriangles;
+
+        if(!polygon->fillTriangles.empty() && style->backgroundColor.a > 0) {
+            primitive.color = style->backgroundColor;
+            primitive.points = polygon->boxPoints.data();
+            primitive.indices = polygon->fillTriangles.data();
+            primitive.count = (uint32_t)polygon->fillTriangles.size();
+            addPrimitive(primitive, clip, left, top, right, bottom);
+        }
+
+        //mitered corners reach out up to twice the stroke width
+        if(polygon->strokeOutline.size() >= 6 && style->borderColor.a > 0) {
+            int64_t reach = 2 * toSubpixels(polygon->geometryStrokeWidth);
+            primitive.color = style->borderColor;
+            primitive.points = polygon->strokeOutline.data();
+            primitive.indices = nullptr;
+            primitive.count = (uint32_t)(polygon->strokeOutline.size() / 2);
+            addPrimitive(primitive, clip, left - reach, top - reach, right + reach, bottom + reach);
+        }
+        return;
+    }
+
+    if(style->backgroundColor.a > 0 || (borderWidth > 0 && style->borderColor.a > 0)) {
+        primitive.type = PrimitiveRoundedRect;
+        primitive.color = style->backgroundColor;
+        primitive.borderColor = style->borderColor;
+        primitive.box[0] = left;
+        primitive.box[1] = top;
+        primitive.box[2] = right;
+        primitive.box[3] = bottom;
+        primitive.radius = (std::max)((int64_t)0, (std::min)(toSubpixels(style->borderRadius), (std::min)(right - left, bottom - top) / 2));
+        primitive.borderWidth = borderWidth;
+        addPrimitive(primitive, clip, left, top, right, bottom);
+    }
+
+    //one primitive per line so a tall text is only drawn in the tiles its lines are in
+    if(element->elementType == ElementTypeText && glyphBlitter != nullptr) {
+        BasicText<Coord>* text = (BasicText<Coord>*)element;
+        uint32_t lineCount = (uint32_t)(text->textBuffer != nullptr ? text->wrappedSpans.size() : text->wrappedText.size());
+        Coord lineHeight = glyphBlitter->getLineHeight(text->font);
+        Coord lineX = (Coord)(element->layout.x + style->paddingLeft + style->borderWidth);
+        Coord lineWidth = (Coord)(element->layout.width - style->paddingLeft - style->paddingRight - 2 * style->borderWidth);
+        int64_t lineTop = top + toSubpixels(style->paddingTop) + borderWidth;
+
+        primitive.type = PrimitiveTextLine;
+        primitive.color = text->color;
+        primitive.text = text;
+        for(uint32_t line = 0; line < lineCount; line++) {
+            primitive.line = line;
+            primitive.lineBox[0] = lineX;
+            primitive.lineBox[1] = (Coord)(element->layout.y + style->paddingTop + style->borderWidth + (double)lineHeight * line);
+            primitive.lineBox[2] = lineWidth;
+            primitive.lineBox[3] = lineHeight;
+            int64_t lineLeft = toSubpixels(lineX);
+            addPrimitive(primitive, clip, lineLeft, lineTop, lineLeft + toSubpixels(lineWidth), lineTop + toSubpixels(lineHeight));
+            lineTop += toSubpixels(lineHeight);
+        }
+    }
+
+    if(!isContainerType(element->elementType)) {
+        return;
+    }
+
+    //hidden overflow is cut at the padding box
+    int childClip[4] = {clip[0], clip[1], clip[2], clip[3]};
+    if(style->overflow == OverflowHide) {
+        childClip[0] = (std::max)(childClip[0], clampToInt(floorDivide(left + borderWidth + Subpixels / 2, Subpixels), 0, width));
+        childClip[1] = (std::max)(childClip[1], clampToInt(floorDivide(top + borderWidth + Subpixels / 2, Subpixels), 0, height));
+        childClip[2] = (std::min)(childClip[2], clampToInt(floorDivide(right - borderWidth + Subpixels / 2, Subpixels), 0, width));
+        childClip[3] = (std::min)(childClip[3], clampToInt(floorDivide(bottom - borderWidth + Subpixels / 2, Subpixels), 0, height));
+        if(childClip[0] >= childClip[2] || childClip[1] >= childClip[3]) {
+            return;
+        }
+    }
+
+    //the children are sorted by zIndex in a shared scratch list, deeper calls use the part after this one's
+    BasicContainer<Coord>* container = (BasicContainer<Coord>*)element;
+    size_t begin = paintOrder.size();
+    paintOrder.insert(paintOrder.end(), container->children.begin(), container->children.end());
+    size_t end = paintOrder.size();
+    std::stable_sort(paintOrder.begin() + begin, paintOrder.end(),
+        [](const BasicBaseElement<Coord>* a, const BasicBaseElement<Coord>* b) { return a->zIndex < b->zIndex; });
+
+    for(size_t i = begin; i < end; i++) {
+        collectPrimitives(paintOrder[i], childClip);
+    }
+    paintOrder.resize(begin);
+}
+
+//Sorts the primitive indices by tile, a primitive is listed in every tile its clip touches and the paint order is kept
+template<typename Coord>
+void BasicTileRasterizer<Coord>::binPrimitives() {
+
+    tileColumns = (width + tileSize - 1) / tileSize;
+    int tileRows = (height + tileSize - 1) / tileSize;
+    tileCount = tileColumns * tileRows;
+
+    tileStarts.assign(tileCount + 1, 0);
+    for(size_t i = 0; i < primitives.size(); i++) {
+        const int* clip = primitives[i].clip;
+        for(int row = clip[1] / tileSize; row <= (clip[3] - 1) / tileSize; row++) {
+            for(int column = clip[0] / tileSize; column <= (clip[2] - 1) / tileSize; column++) {
+                tileStarts[row * tileColumns + column + 1]++;
+            }
+        }
+    }
+    for(int tile = 0; tile < tileCount; tile++) {
+        tileStarts[tile + 1] += tileStarts[tile];
+    }
+
+    //each tile's start is used as its fill cursor, then moved back one tile
+    tilePrimitives.resize(tileStarts[tileCount]);
+    for(size_t i = 0; i < primitives.size(); i++) {
+        const int* clip = primitives[i].clip;
+        for(int row = clip[1] / tileSize; row <= (clip[3] - 1) / tileSize; row++) {
+            for(int column = clip[0] / tileSize; column <= (clip[2] - 1) / tileSize; column++) {
+                tilePrimitives[tileStarts[row * tileColumns + column]++] = (uint32_t)i;
+            }
+        }
+    }
+    for(int tile = tileCount; tile > 0; tile--) {
+        tileStarts[tile] = tileStarts[tile - 1];
+    }
+    tileStarts[0] = 0;
+}
+
+//
+//Tiles, each one is drawn start to finish by one thread
+//
+
+template<typename Coord>
+void BasicTileRasterizer<Coord>::drawTiles(Worker* worker) {
+    while(true) {
+        int tile = nextTile.fetch_add(1);
+        if(tile >= tileCount) {
+            return;
+        }
+        drawTile(worker, tile);
+    }
+}
+
+template<typename Coord>
+void BasicTileRasterizer<Coord>::drawTile(Worker* worker, int tile) {
+
+    RasterTarget tileTarget;
+    tileTarget.pixels = pixels;
+    tileTarget.stride = stride;
+    tileTarget.clipLeft = (tile % tileColumns) * tileSize;
+    tileTarget.clipTop = (tile / tileColumns) * tileSize;
+    tileTarget.clipRight = (std::min)(tileTarget.clipLeft + tileSize, width);
+    tileTarget.clipBottom = (std::min)(tileTarget.clipTop + tileSize, height);
+
+    for(int y = tileTarget.clipTop; y < tileTarget.clipBottom; y++) {
+        uint8_t* pixel = pixels + (size_t)y * stride + (size_t)tileTarget.clipLeft * 4;
+        for(int x = tileTarget.clipLeft; x < tileTarget.clipRight; x++, pixel += 4) {
+            pixel[0] = clearColor.r;
+            pixel[1] = clearColor.g;
+            pixel[2] = clearColor.b;
+            pixel[3] = clearColor.a;
+        }
+    }
+
+    for(uint32_t i = tileStarts[tile]; i < tileStarts[tile + 1]; i++) {
+        const Primitive& primitive = primitives[tilePrimitives[i]];
+        RasterTarget target = tileTarget;
+        target.clipLeft = (std::max)(target.clipLeft, primitive.clip[0]);
+        target.clipTop = (std::max)(target.clipTop, primitive.clip[1]);
+        target.clipRight = (std::min)(target.clipRight, primitive.clip[2]);
+        target.clipBottom = (std::min)(target.clipBottom, primitive.clip[3]);
+
+        switch(primitive.type) {
+            case PrimitiveRoundedRect:
+                drawRoundedRect(primitive, target);
+                break;
+            case PrimitiveTriangles:
+                drawTriangles(worker, primitive, target);
+                break;
+            case PrimitiveTextLine:
+                drawTextLine(primitive, target);
+                break;
+        }
+    }
+}
+
+//The background covers the whole box, the border is the ring between the box and the box inset by the border width
+template<typename Coord>
+void BasicTileRasterizer<Coord>::drawRoundedRect(const Primitive& primitive, const RasterTarget& target) {
+
+    RoundedBox outer = {primitive.box[0], primitive.box[1], primitive.box[2], primitive.box[3], primitive.radius};
+    bool hasBorder = primitive.borderWidth > 0 && primitive.borderColor.a > 0;
+    RoundedBox inner = {outer.left + primitive.borderWidth, outer.top + primitive.borderWidth, outer.right - primitive.borderWidth,
+        outer.bottom - primitive.borderWidth, (std::max)((int64_t)0, primitive.radius - primitive.borderWidth)};
+
+    for(int y = target.clipTop; y < target.clipBottom; y++) {
+        for(int x = target.clipLeft; x < target.clipRight; x++) {
+            int outerSamples = countSamples(outer, x, y);
+            if(outerSamples == 0) {
+                continue;
+            }
+            if(primitive.color.a > 0) {
+                blendPixel(target, x, y, primitive.color, samplesToCoverage(outerSamples));
+            }
+            if(hasBorder) {
+                int ringSamples = outerSamples - countSamples(inner, x, y);
+                if(ringSamples > 0) {
+                    blendPixel(target, x, y, primitive.borderColor, samplesToCoverage(ringSamples));
+                }
+            }
+        }
+    }
+}
+
+//The samples each triangle covers are gathered first and the shape is blended once, so the edges shared by two
+//triangles don't show. Each pixel keeps a mask of its samples rather than a count, the triangles of a stroke strip
+//overlap at the joins and a sample covered twice must still only count once.
+template<typename Coord>
+void BasicTileRasterizer<Coord>::drawTriangles(Worker* worker, const Primitive& primitive, const RasterTarget& target) {
+
+    int targetWidth = target.clipRight - target.clipLeft;
+    int targetHeight = target.clipBottom - target.clipTop;
+    if(targetWidth <= 0 || targetHeight <= 0) {
+        return;
+    }
+    uint16_t* coverage = worker->coverage.data();
+    std::fill(coverage, coverage + (size_t)targetWidth * targetHeight, 0);
+
+    uint32_t triangleCount = primitive.indices != nullptr ? primitive.count / 3 : (primitive.count >= 3 ? primitive.count - 2 : 0);
+    for(uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+        uint32_t corners[3];
+        for(int corner = 0; corner < 3; corner++) {
+            corners[corner] = primitive.indices != nullptr ? primitive.indices[triangle * 3 + corner] : triangle + corner;
+        }
+        int64_t x0 = toSubpixels(primitive.points[corners[0] * 2]), y0 = toSubpixels(primitive.points[corners[0] * 2 + 1]);
+        int64_t x1 = toSubpixels(primitive.points[corners[1] * 2]), y1 = toSubpixels(primitive.points[corners[1] * 2 + 1]);
+        int64_t x2 = toSubpixels(primitive.points[corners[2] * 2]), y2 = toSubpixels(primitive.points[corners[2] * 2 + 1]);
+
+        //every triangle is turned the same way so inside is the same side of all edges
+        int64_t area = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+        if(area == 0) {
+            continue;
+        }
+        if(area < 0) {
+            std::swap(x1, x2);
+            std::swap(y1, y2);
+        }
+        Edge edges[3] = {Edge(x0, y0, x1, y1), Edge(x1, y1, x2, y2), Edge(x2, y2, x0, y0)};
+
+        int left = clampToInt(floorDivide((std::min)(x0, (std::min)(x1, x2)), Subpixels), target.clipLeft, target.clipRight);
+        int top = clampToInt(floorDivide((std::min)(y0, (std::min)(y1, y2)), Subpixels), target.clipTop, target.clipBottom);
+        int right = clampToInt(floorDivide((std::max)(x0, (std::max)(x1, x2)), Subpixels) + 1, target.clipLeft, target.clipRight);
+        int bottom = clampToInt(floorDivide((std::max)(y0, (std::max)(y1, y2)), Subpixels) + 1, target.clipTop, target.clipBottom);
+
+        for(int y = top; y < bottom; y++) {
+            uint16_t* row = coverage + (size_t)(y - target.clipTop) * targetWidth;
+            for(int x = left; x < right; x++) {
+                uint16_t samples = 0;
+                for(int sy = 0; sy < 4; sy++) {
+                    int64_t sampleY = (int64_t)y * Subpixels + SampleOffsets[sy];
+                    for(int sx = 0; sx < 4; sx++) {
+                        int64_t sampleX = (int64_t)x * Subpixels + SampleOffsets[sx];
+                        if(edges[0].inside(sampleX, sampleY) && edges[1].inside(sampleX, sampleY) && edges[2].inside(sampleX, sampleY)) {
+                            samples |= (uint16_t)(1 << (sy * 4 + sx));
+                        }
+                    }
+                }
+                row[x - target.clipLeft] |= samples;
+            }
+        }
+    }
+
+    for(int y = 0; y < targetHeight; y++) {
+        const uint16_t* row = coverage + (size_t)y * targetWidth;
+        for(int x = 0; x < targetWidth; x++) {
+            if(row[x] != 0) {
+                blendPixel(target, target.clipLeft + x, target.clipTop + y, primitive.color, samplesToCoverage(countSampleBits(row[x])));
+            }
+        }
+    }
+}
+
+template<typename Coord>
+void BasicTileRasterizer<Coord>::drawTextLine(const Primitive& primitive, const RasterTarget& target) {
+
+    const BasicText<Coord>* text = primitive.text;
+    const char* data;
+    size_t length;
+    std::string truncatedLine;
+    if(text->textBuffer != nullptr) {
+        const TextSpan& span = text->wrappedSpans[primitive.line];
+        data = text->textBuffer->data + span.offset;
+        length = span.length;
+
+        //the spans of external text can't hold the ellipsis of a truncated last line
+        if(text->truncated && primitive.line + 1 == text->wrappedSpans.size()) {
+            truncatedLine.assign(data, length);
+            truncatedLine.append("\xE2\x80\xA6");
+            data = truncatedLine.data();
+            length = truncatedLine.size();
+        }
+    }
+    else {
+        const std::string& line = text->wrappedText[primitive.line];
+        data = line.data();
+        length = line.size();
+    }
+
+    glyphBlitter->drawLine(target, data, length, text->font, text->color, text->textAlign,
+        primitive.lineBox[0], primitive.lineBox[1], primitive.lineBox[2], primitive.lineBox[3]);
+}
+
+template class BasicGlyphBlitter<int16_t>;
+template class BasicGlyphBlitter<int32_t>;
+template class BasicGlyphBlitter<float>;
+template class BasicTileRasterizer<int16_t>;
+template class BasicTileRasterizer<int32_t>;
+template class BasicTileRasterizer<float>;
+
+} // namespace TinyLayoutEngine
\ No newline at end of file
@@ -0,0 +1,123 @@
+#ifndef TINY_LAYOUT_ENGINE_RASTER_HPP
+#define TINY_LAYOUT_ENGINE_RASTER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <atomic>
+
+#include "tinyLayoutEngine.hpp"
+
+namespace TinyLayoutEngine {
+
+//The part of an image a raster thread draws into. Pixels are RGBA, 4 bytes each, rows are stride bytes apart and
+//only the pixels from clipLeft to clipRight - 1 and clipTop to clipBottom - 1 may be written.
+struct RasterTarget {
+    uint8_t* pixels; // Top left pixel of the whole image
+    int stride;
+    int clipLeft;
+    int clipTop;
+    int clipRight;
+    int clipBottom;
+};
+
+//Blends a color over one pixel with a coverage from 0 to 255. The color channels are blended as if the pixel was
+//opaque, the alpha channel is composited. Does nothing outside the target's clip.
+void blendPixel(const RasterTarget& target, int x, int y, Color color, uint32_t coverage);
+
+//Draws text for the rasterizer, implemented by the caller with their font engine. Lines are drawn from several raster
+//threads at once so it must be thread safe, and for the image to be deterministic the same line must always give
+//the same pixels. Glyphs are clipped to the target, which is never bigger than one tile.
+template<typename Coord>
+class BasicGlyphBlitter {
+public:
+    virtual ~BasicGlyphBlitter() = default;
+
+    //Line height of a font, the same as the measurement context used for the layout gives
+    virtual Coord getLineHeight(uint8_t font) = 0;
+
+    //Draws one line of text aligned inside the box at x, y that is width wide and lineHeight high
+    virtual void drawLine(const RasterTarget& target, const char* text, size_t length, uint8_t font, Color color,
+        TextAlignment textAlign, Coord x, Coord y, Coord width, Coord lineHeight) = 0;
+};
+
+//Software rasterizer for laid out trees. The tree is turned into primitives in paint order: rounded rectangle
+//backgrounds and borders, polygon fills and strokes from the geometry the layout built, and text lines. The
+//primitives are binned into square tiles and the tiles are drawn in parallel, each one by a single thread in paint
+//order, so the image is the same byte for byte whatever the thread count. Shapes are anti-aliased with 16 integer
+//samples per pixel. Children are painted after their parent, by zIndex then in tree order, and containers with
+//OverflowHide clip their children to their padding box. Native builds only, it needs threads.
+template<typename Coord>
+class BasicTileRasterizer {
+public:
+    BasicTileRasterizer(int threadCount, int tileSize = 64);
+    BasicTileRasterizer(const BasicTileRasterizer&) = delete;
+    BasicTileRasterizer& operator=(const BasicTileRasterizer&) = delete;
+
+    //Clears width by height pixels to the clear color and draws a laid out tree into them, one layout unit is one
+    //pixel. Without a glyph blitter the text is left out. The calling thread takes part and returns once all is drawn.
+    void draw(BasicContainer<Coord>* root, uint8_t* pixels, int width, int height, int stride, Color clearColor,
+        BasicGlyphBlitter<Coord>* glyphBlitter);
+
+private:
+    enum PrimitiveType : uint8_t {
+        PrimitiveRoundedRect, // Background and border of a box
+        PrimitiveTriangles, // Index triples into the points, or a strip when there are no indices
+        PrimitiveTextLine
+    };
+
+    struct Primitive {
+        PrimitiveType type;
+        Color color; // Fill, triangle or text color
+        Color borderColor;
+        int clip[4]; // Left, top, right and bottom pixel the primitive may touch, the right and bottom are excluded
+        int64_t box[4]; // Left, top, right and bottom of a rectangle in sixteenths of a pixel
+        int64_t radius; // Corner radius and border width of a rectangle, in sixteenths of a pixel
+        int64_t borderWidth;
+        const Coord* points; // Triangle vertices as x, y pairs in layout units
+        const uint32_t* indices;
+        uint32_t count; // Number of indices, or of vertices for a strip
+        BasicText<Coord>* text; // Text and index of a text line
+        uint32_t line;
+        Coord lineBox[4]; // Left, top, width and height of a text line in layout units
+    };
+
+    struct Worker {
+        std::vector<uint16_t> coverage; // Mask of the samples covered per pixel of the tile, for shapes made of several triangles
+    };
+
+    int tileSize;
+    std::vector<Worker> workers;
+
+    //the current draw
+    std::vector<Primitive> primitives;
+    std::vector<uint32_t> tileStarts; // Offset of each tile's primitives in tilePrimitives, one more than the tiles
+    std::vector<uint32_t> tilePrimitives; // Primitive indices of each tile in paint order
+    std::vector<BasicBaseElement<Coord>*> paintOrder; // Scratch for sorting children by zIndex
+    uint8_t* pixels;
+    int width;
+    int height;
+    int stride;
+    int tileColumns;
+    int tileCount;
+    Color clearColor;
+    BasicGlyphBlitter<Coord>* glyphBlitter;
+    std::atomic<int> nextTile;
+    WorkerPool pool; // Last so its threads stop before the rest is destroyed
+
+    void collectPrimitives(BasicBaseElement<Coord>* element, const int clip[4]);
+    void addPrimitive(const Primitive& primitive, const int clip[4], int64_t left, int64_t top, int64_t right, int64_t bottom);
+    void binPrimitives();
+    void drawTiles(Worker* worker);
+    void drawTile(Worker* worker, int tile);
+    void drawRoundedRect(const Primitive& primitive, const RasterTarget& target);
+    void drawTriangles(Worker* worker, const Primitive& primitive, const RasterTarget& target);
+    void drawTextLine(const Primitive& primitive, const RasterTarget& target);
+};
+
+typedef BasicGlyphBlitter<int16_t> GlyphBlitter;
+typedef BasicTileRasterizer<int16_t> TileRasterizer;
+
+} // namespace TinyLayoutEngine
+
+#endif // TINY_LAYOUT_ENGINE_RASTER_HPP
\ No newline at end of file
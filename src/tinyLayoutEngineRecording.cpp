@@ -0,0 +1,358 @@
+//Layout recordings. A recording is a header, the snapshot of the input tree and the recorded measurements. Each
+//distinct query is stored once with its answer, the engine asks the same questions in the same order on replay so
+//that is all a replay needs.
+
+#include "tinyLayoutEngineRecording.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace TinyLayoutEngine {
+
+namespace {
+
+const char RecordingMagic[8] = {'T', 'L', 'E', 'R', 'E', 'C', 'O', 'R'};
+const uint32_t RecordingVersion = 2; // Bump whenever the layout of a recording changes
+
+struct RecordingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t coordType; // Size of the coordinate type, plus 0x100 for floating point
+    uint32_t treeSize; // Size of the tree snapshot, it follows the header
+    uint32_t widthCount; // Text width records, they follow the snapshot
+    uint32_t lineHeightCount; // Line height records, they follow the text widths
+    uint32_t advancesCount; // Text advance records, they follow the line heights
+    uint32_t checksum; // Over everything after the header
+    uint32_t padding; // Keeps the snapshot after the header 8 byte aligned
+};
+
+struct TextWidthRecord {
+    double value;
+    uint32_t textLength; // The text follows the record
+    uint8_t font;
+    uint8_t padding[3];
+};
+
+struct LineHeightRecord {
+    double value;
+    int16_t lineSpacing;
+    uint8_t font;
+    uint8_t padding[5];
+};
+
+struct AdvancesRecord {
+    uint32_t textLength; // The text follows the record, then textLength advances as doubles when supported
+    uint8_t font;
+    uint8_t supported; // 0 when the context returned false
+    uint8_t padding[2];
+};
+
+template<typename Coord>
+uint32_t coordType() {
+    return (uint32_t)sizeof(Coord) | (std::numeric_limits<Coord>::is_integer ? 0 : 0x100);
+}
+
+uint32_t lineHeightKey(int16_t lineSpacing, uint8_t font) {
+    return ((uint32_t)(uint16_t)lineSpacing << 8) | font;
+}
+
+//FNV-1a
+uint32_t hashBytes(uint32_t hash, const void* bytes, size_t length) {
+    const uint8_t* p = (const uint8_t*)bytes;
+    for(size_t i = 0; i < length; i++) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+size_t alignRecord(size_t offset) {
+    return (offset + 7) & ~(size_t)7;
+}
+
+void appendBytes(std::vector<uint8_t>& out, const void* bytes, size_t length) {
+    out.insert(out.end(), (const uint8_t*)bytes, (const uint8_t*)bytes + length);
+    out.resize(alignRecord(out.size()), 0);
+}
+
+} // namespace
+
+template<typename Coord>
+BasicMeasurementRecorder<Coord>::BasicMeasurementRecorder(BasicMeasurementContext<Coord>* measurementContext) {
+    this->measurementContext = measurementContext;
+}
+
+template<typename Coord>
+void BasicMeasurementRecorder<Coord>::captureTree(BasicContainer<Coord>* root) {
+    BasicSnapshot<Coord>::write(root, tree);
+}
+
+template<typename Coord>
+void BasicMeasurementRecorder<Coord>::clear() {
+    tree.clear();
+    textWidths.clear();
+    textAdvances.clear();
+    lineHeights.clear();
+}
+
+template<typename Coord>
+bool BasicMeasurementRecorder<Coord>::save(const char* path) {
+
+    //everything after the header is built in memory first so it can be checksummed
+    std::vector<uint8_t> body;
+    appendBytes(body, tree.data(), tree.size());
+
+    for(typename std::unordered_map<std::string, Coord>::iterator it = textWidths.begin(); it != textWidths.end(); ++it) {
+        TextWidthRecord record;
+        memset(&record, 0, sizeof(record));
+        record.value = (double)it->second;
+        record.textLength = (uint32_t)it->first.size() - 1;
+        record.font = (uint8_t)it->first[0];
+        body.insert(body.end(), (const uint8_t*)&record, (const uint8_t*)(&record + 1));
+        appendBytes(body, it->first.data() + 1, record.textLength);
+    }
+
+    for(typename std::unordered_map<uint32_t, Coord>::iterator it = lineHeights.begin(); it != lineHeights.end(); ++it) {
+        LineHeightRecord record;
+        memset(&record, 0, sizeof(record));
+        record.value = (double)it->second;
+        record.lineSpacing = (int16_t)(it->first >> 8);
+        record.font = (uint8_t)(it->first & 0xff);
+        appendBytes(body, &record, sizeof(record));
+    }
+
+    for(typename std::unordered_map<std::string, std::vector<Coord>>::iterator it = textAdvances.begin(); it != textAdvances.end(); ++it) {
+        AdvancesRecord record;
+        memset(&record, 0, sizeof(record));
+        record.textLength = (uint32_t)it->first.size() - 1;
+        record.font = (uint8_t)it->first[0];
+        record.supported = it->second.empty() && record.textLength > 0 ? 0 : 1;
+        body.insert(body.end(), (const uint8_t*)&record, (const uint8_t*)(&record + 1));
+        appendBytes(body, it->first.data() + 1, record.textLength);
+        for(size_t i = 0; i < it->second.size(); i++) {
+            double value = (double)it->second[i];
+            appendBytes(body, &value, sizeof(value));
+        }
+    }
+
+    RecordingHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RecordingMagic, sizeof(RecordingMagic));
+    header.version = RecordingVersion;
+    header.coordType = coordType<Coord>();
+    header.treeSize = (uint32_t)tree.size();
+    header.widthCount = (uint32_t)textWidths.size();
+    header.lineHeightCount = (uint32_t)lineHeights.size();
+    header.advancesCount = (uint32_t)textAdvances.size();
+    header.checksum = hashBytes(2166136261u, body.data(), body.size());
+
+    FILE* file = fopen(path, "wb");
+    if(file == nullptr) {
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 && (body.empty() || fwrite(body.data(), body.size(), 1, file) == 1);
+    return fclose(file) == 0 && written;
+}
+
+template<typename Coord>
+Coord BasicMeasurementRecorder<Coord>::measureTextWidth(std::string& str, uint8_t font) {
+    Coord width = measurementContext->measureTextWidth(str, font);
+    key.assign(1, (char)font);
+    key += str;
+    textWidths[key] = width;
+    return width;
+}
+
+template<typename Coord>
+Coord BasicMeasurementRecorder<Coord>::measureTextSpanWidth(const char* str, size_t length, uint8_t font) {
+    Coord width = measurementContext->measureTextSpanWidth(str, length, font);
+    key.assign(1, (char)font);
+    key.append(str, length);
+    textWidths[key] = width;
+    return width;
+}
+
+//a context without advances is recorded with none, so the replay also falls back to measuring prefixes
+template<typename Coord>
+bool BasicMeasurementRecorder<Coord>::measureTextAdvances(const char* str, size_t length, uint8_t font, Coord* advances) {
+    bool supported = measurementContext->measureTextAdvances(str, length, font, advances);
+    key.assign(1, (char)font);
+    key.append(str, length);
+    std::vector<Coord>& recorded = textAdvances[key];
+    if(supported) recorded.assign(advances, advances + length);
+    else recorded.clear();
+    return supported;
+}
+
+template<typename Coord>
+Coord BasicMeasurementRecorder<Coord>::getLineHeight(int16_t lineSpacing, uint8_t font) {
+    Coord lineHeight = measurementContext->getLineHeight(lineSpacing, font);
+    lineHeights[lineHeightKey(lineSpacing, font)] = lineHeight;
+    return lineHeight;
+}
+
+template<typename Coord>
+BasicMeasurementReplay<Coord>::BasicMeasurementReplay() {
+    missCount = 0;
+}
+
+template<typename Coord>
+bool BasicMeasurementReplay<Coord>::load(const char* path) {
+    textWidths.clear();
+    textAdvances.clear();
+    lineHeights.clear();
+    missCount = 0;
+
+    FILE* input = fopen(path, "rb");
+    if(input == nullptr) {
+        return false;
+    }
+    fseek(input, 0, SEEK_END);
+    long fileSize = ftell(input);
+    fseek(input, 0, SEEK_SET);
+    if(fileSize < (long)sizeof(RecordingHeader)) {
+        fclose(input);
+        return false;
+    }
+    file.assign(((size_t)fileSize + 7) / 8, 0);
+    bool read = fread(file.data(), (size_t)fileSize, 1, input) == 1;
+    fclose(input);
+    if(!read) {
+        return false;
+    }
+
+    const uint8_t* data = (const uint8_t*)file.data();
+    const RecordingHeader* header = (const RecordingHeader*)data;
+    const uint8_t* body = data + sizeof(RecordingHeader);
+    size_t bodySize = (size_t)fileSize - sizeof(RecordingHeader);
+
+    if(memcmp(header->magic, RecordingMagic, sizeof(RecordingMagic)) != 0 || header->version != RecordingVersion ||
+        header->coordType != coordType<Coord>() || header->checksum != hashBytes(2166136261u, body, bodySize) ||
+        header->treeSize > bodySize || !tree.open(body, header->treeSize)) {
+        return false;
+    }
+
+    //the records are only read once, into the lookup tables
+    size_t offset = alignRecord(header->treeSize);
+    for(uint32_t i = 0; i < header->widthCount; i++) {
+        if(offset + sizeof(TextWidthRecord) > bodySize) {
+            return false;
+        }
+        const TextWidthRecord* record = (const TextWidthRecord*)(body + offset);
+        offset += sizeof(TextWidthRecord);
+        if(record->textLength > bodySize - offset) {
+            return false;
+        }
+        key.assign(1, (char)record->font);
+        key.append((const char*)(body + offset), record->textLength);
+        textWidths[key] = (Coord)record->value;
+        offset = alignRecord(offset + record->textLength);
+    }
+
+    for(uint32_t i = 0; i < header->lineHeightCount; i++) {
+        if(offset + sizeof(LineHeightRecord) > bodySize) {
+            return false;
+        }
+        const LineHeightRecord* record = (const LineHeightRecord*)(body + offset);
+        lineHeights[lineHeightKey(record->lineSpacing, record->font)] = (Coord)record->value;
+        offset += sizeof(LineHeightRecord);
+    }
+
+    for(uint32_t i = 0; i < header->advancesCount; i++) {
+        if(offset + sizeof(AdvancesRecord) > bodySize) {
+            return false;
+        }
+        const AdvancesRecord* record = (const AdvancesRecord*)(body + offset);
+        offset += sizeof(AdvancesRecord);
+        if(record->textLength > bodySize - offset) {
+            return false;
+        }
+        key.assign(1, (char)record->font);
+        key.append((const char*)(body + offset), record->textLength);
+        offset = alignRecord(offset + record->textLength);
+
+        std::vector<Coord>& advances = textAdvances[key];
+        advances.clear();
+        if(record->supported) {
+            if(offset > bodySize || record->textLength > (bodySize - offset) / sizeof(double)) {
+                return false;
+            }
+            const double* values = (const double*)(body + offset);
+            for(uint32_t j = 0; j < record->textLength; j++) {
+                advances.push_back((Coord)values[j]);
+            }
+            offset += (size_t)record->textLength * sizeof(double);
+        }
+    }
+
+    return true;
+}
+
+template<typename Coord>
+BasicContainer<Coord>* BasicMeasurementReplay<Coord>::copyTree() const {
+    return tree.copyToTree();
+}
+
+template<typename Coord>
+Coord BasicMeasurementReplay<Coord>::measureTextWidth(std::string& str, uint8_t font) {
+    key.assign(1, (char)font);
+    key += str;
+
+    typename std::unordered_map<std::string, Coord>::iterator found = textWidths.find(key);
+    if(found == textWidths.end()) {
+        missCount++;
+        return 0;
+    }
+    return found->second;
+}
+
+template<typename Coord>
+Coord BasicMeasurementReplay<Coord>::measureTextSpanWidth(const char* str, size_t length, uint8_t font) {
+    key.assign(1, (char)font);
+    key.append(str, length);
+
+    typename std::unordered_map<std::string, Coord>::iterator found = textWidths.find(key);
+    if(found == textWidths.end()) {
+        missCount++;
+        return 0;
+    }
+    return found->second;
+}
+
+//advances recorded as unsupported are answered the same way, the layout then measures prefixes as it did
+template<typename Coord>
+bool BasicMeasurementReplay<Coord>::measureTextAdvances(const char* str, size_t length, uint8_t font, Coord* advances) {
+    key.assign(1, (char)font);
+    key.append(str, length);
+
+    typename std::unordered_map<std::string, std::vector<Coord>>::iterator found = textAdvances.find(key);
+    if(found == textAdvances.end()) {
+        missCount++;
+        return false;
+    }
+    if(found->second.size() != length) {
+        return false;
+    }
+    std::copy(found->second.begin(), found->second.end(), advances);
+    return true;
+}
+
+template<typename Coord>
+Coord BasicMeasurementReplay<Coord>::getLineHeight(int16_t lineSpacing, uint8_t font) {
+    typename std::unordered_map<uint32_t, Coord>::iterator found = lineHeights.find(lineHeightKey(lineSpacing, font));
+    if(found == lineHeights.end()) {
+        missCount++;
+        return 0;
+    }
+    return found->second;
+}
+
+template class BasicMeasurementRecorder<int16_t>;
+template class BasicMeasurementRecorder<int32_t>;
+template class BasicMeasurementRecorder<float>;
+template class BasicMeasurementReplay<int16_t>;
+template class BasicMeasurementReplay<int32_t>;
+template class BasicMeasurementReplay<float>;
+
+} // namespace TinyLayoutEngine
\ No newline at end of file
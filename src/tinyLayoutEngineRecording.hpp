@@ -0,0 +1,83 @@
+#ifndef TINY_LAYOUT_ENGINE_RECORDING_HPP
+#define TINY_LAYOUT_ENGINE_RECORDING_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "tinyLayoutEngine.hpp"
+#include "tinyLayoutEngineSnapshot.hpp"
+
+namespace TinyLayoutEngine {
+
+//Records a production layout so it can be replayed offline: the input tree as a snapshot and the answer to every
+//measurement the layout asked for, text advances included. Use it as the measurement context of the layout being 
+//recorded, it forwards every query to the real context so the layout takes the same paths it takes without it.
+template<typename Coord>
+class BasicMeasurementRecorder : public BasicMeasurementContext<Coord> {
+public:
+    BasicMeasurementRecorder(BasicMeasurementContext<Coord>* measurementContext);
+
+    //Captures the input tree, call before the layout being recorded
+    void captureTree(BasicContainer<Coord>* root);
+
+    //Writes the captured tree and the recorded measurements, returns false if the file couldn't be written
+    bool save(const char* path);
+
+    //Forgets the recorded measurements and tree
+    void clear();
+
+    Coord measureTextWidth(std::string& str, uint8_t font) override;
+    Coord measureTextSpanWidth(const char* str, size_t length, uint8_t font) override;
+    bool measureTextAdvances(const char* str, size_t length, uint8_t font, Coord* advances) override;
+    Coord getLineHeight(int16_t lineSpacing, uint8_t font) override;
+
+private:
+    BasicMeasurementContext<Coord>* measurementContext;
+    std::vector<uint8_t> tree; // Snapshot of the input tree
+    std::unordered_map<std::string, Coord> textWidths; // Keyed by the font byte followed by the text
+    std::unordered_map<std::string, std::vector<Coord>> textAdvances; // Same keys, empty when the context had no advances
+    std::unordered_map<uint32_t, Coord> lineHeights; // Keyed by line spacing and font
+    std::string key; // Scratch for building keys
+};
+
+//Plays a recording back, answering measurements from it so a layout can be rerun exactly as it ran in production
+template<typename Coord>
+class BasicMeasurementReplay : public BasicMeasurementContext<Coord> {
+public:
+    BasicMeasurementReplay();
+
+    //Loads a recording, returns false if it is missing, damaged or recorded with another coordinate type
+    bool load(const char* path);
+
+    //Builds a new copy of the recorded input tree, external text shows a buffer owned by the replay so the copy
+    //must be destroyed before the replay is
+    BasicContainer<Coord>* copyTree() const;
+
+    //Measurements asked for that are not in the recording, they are answered with 0. Not 0 means the replay
+    //diverged from the recorded layout.
+    uint32_t getMissCount() const { return missCount; }
+
+    Coord measureTextWidth(std::string& str, uint8_t font) override;
+    Coord measureTextSpanWidth(const char* str, size_t length, uint8_t font) override;
+    bool measureTextAdvances(const char* str, size_t length, uint8_t font, Coord* advances) override;
+    Coord getLineHeight(int16_t lineSpacing, uint8_t font) override;
+
+private:
+    std::vector<uint64_t> file; // The recording, 64 bit words so the snapshot inside is aligned
+    BasicSnapshot<Coord> tree;
+    std::unordered_map<std::string, Coord> textWidths;
+    std::unordered_map<std::string, std::vector<Coord>> textAdvances;
+    std::unordered_map<uint32_t, Coord> lineHeights;
+    std::string key;
+    uint32_t missCount;
+};
+
+typedef BasicMeasurementRecorder<int16_t> MeasurementRecorder;
+typedef BasicMeasurementReplay<int16_t> MeasurementReplay;
+
+} // namespace TinyLayoutEngine
+
+#endif // TINY_LAYOUT_ENGINE_RECORDING_HPP
\ No newline at end of file
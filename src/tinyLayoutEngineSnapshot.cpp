@@ -0,0 +1,596 @@
+//Snapshots of laid out trees. The snapshot is a header followed by sections for the styles, the elements, the
+//wrapped line spans, the coordinates and the string pool, all referenced by offset from the start of the snapshot
+//so it can live at any address. Everything is checked once when a snapshot is opened so reads after that need no checks.
+
+#include "tinyLayoutEngineSnapshot.hpp"
+
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace TinyLayoutEngine {
+
+namespace {
+
+const char SnapshotMagic[8] = {'T', 'L', 'E', 'S', 'N', 'A', 'P', '1'};
+const uint32_t SnapshotVersion = 3; // Bump whenever the layout of a snapshot changes
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t coordType; // Size of the coordinate type, plus 0x100 for floating point
+    uint32_t nodeSize; // Size of a node and a style, so snapshots from a build with another struct layout are refused
+    uint32_t styleSize;
+    uint32_t totalSize;
+
+    uint32_t styleCount;
+    uint32_t nodeCount;
+    uint32_t lineCount;
+    uint32_t coordCount;
+    uint32_t stringsSize;
+
+    uint32_t stylesOffset;
+    uint32_t nodesOffset;
+    uint32_t linesOffset;
+    uint32_t coordsOffset;
+    uint32_t stringsOffset;
+};
+
+template<typename Coord>
+uint32_t coordType() {
+    return (uint32_t)sizeof(Coord) | (std::numeric_limits<Coord>::is_integer ? 0 : 0x100);
+}
+
+//sections start 8 byte aligned
+size_t alignSection(size_t offset) {
+    return (offset + 7) & ~(size_t)7;
+}
+
+bool sectionFits(uint32_t offset, uint32_t count, size_t elementSize, size_t size) {
+    return offset % 8 == 0 && offset <= size && (uint64_t)count * elementSize <= size - offset;
+}
+
+bool spanFits(TextSpan span, uint32_t stringsSize) {
+    return span.offset <= stringsSize && span.length <= stringsSize - span.offset;
+}
+
+} // namespace
+
+template<typename Coord>
+BasicSnapshot<Coord>::BasicSnapshot() {
+    data = nullptr;
+    size = 0;
+    mappedSize = 0;
+}
+
+template<typename Coord>
+BasicSnapshot<Coord>::~BasicSnapshot() {
+    close();
+}
+
+template<typename Coord>
+void BasicSnapshot<Coord>::close() {
+    if(mappedSize > 0) {
+        munmap((void*)data, mappedSize);
+    }
+    data = nullptr;
+    size = 0;
+    mappedSize = 0;
+    stringBuffer.reset();
+}
+
+template<typename Coord>
+void BasicSnapshot<Coord>::write(BasicContainer<Coord>* root, std::vector<uint8_t>& snapshot) {
+    WriteScratch scratch;
+    write(root, snapshot, scratch);
+}
+
+template<typename Coord>
+void BasicSnapshot<Coord>::write(BasicContainer<Coord>* root, std::vector<uint8_t>& snapshot, WriteScratch& scratch) {
+
+    std::vector<BasicBaseElement<Coord>*>& elements = scratch.elements;
+    std::vector<BasicSnapshotNode<Coord>>& nodes = scratch.nodes;
+    std::vector<BasicStyle<Coord>>& styles = scratch.styles;
+    std::vector<StyleHandle>& styleHandles = scratch.styleHandles;
+    std::vector<uint32_t>& styleIndices = scratch.styleIndices;
+    std::vector<TextSpan>& lines = scratch.lines;
+    std::vector<Coord>& coords = scratch.coords;
+    std::string& strings = scratch.strings;
+    elements.clear();
+    nodes.clear();
+    styles.clear();
+    styleHandles.clear();
+    lines.clear();
+    coords.clear();
+    strings.clear();
+
+    //breadth first, the children of each element get the next free indices
+    elements.push_back(root);
+    for(size_t i = 0; i < elements.size(); i++) {
+        BasicBaseElement<Coord>* element = elements[i];
+
+        //zeroed so the padding is the same every time
+        BasicSnapshotNode<Coord> node;
+        memset(&node, 0, sizeof(node));
+
+        node.layout = element->layout;
+        node.width = element->width;
+        node.height = element->height;
+        node.maxWidth = element->maxWidth;
+        node.maxHeight = element->maxHeight;
+        node.minWidth = element->minWidth;
+        node.minHeight = element->minHeight;
+        node.grow = element->grow;
+        node.zIndex = element->zIndex;
+        node.elementType = element->elementType;
+        node.positioning = element->positioning;
+        node.visible = element->visible;
+        node.displayed = element->displayed;
+
+        //the index table is left as it was by the last write, an entry is only trusted if it points back at its handle
+        if(element->style >= styleIndices.size()) {
+            styleIndices.resize((size_t)element->style + 1);
+        }
+        uint32_t styleIndex = styleIndices[element->style];
+        if(styleIndex >= styleHandles.size() || styleHandles[styleIndex] != element->style) {
+            styleIndex = (uint32_t)styles.size();
+            styleIndices[element->style] = styleIndex;
+            styleHandles.push_back(element->style);
+            styles.push_back(*TinyLayoutEngine::getStyle<Coord>(element->style));
+        }
+        node.style = styleIndex;
+
+        if(isContainerType(element->elementType)) {
+            BasicContainer<Coord>* container = (BasicContainer<Coord>*)element;
+            node.firstChild = (uint32_t)elements.size();
+            node.childCount = (uint32_t)container->children.size();
+            elements.insert(elements.end(), container->children.begin(), container->children.end());
+        }
+
+        if(element->elementType == ElementTypeGrid) {
+            BasicGrid<Coord>* grid = (BasicGrid<Coord>*)element;
+            node.columnCount = grid->columnCount;
+            node.columnTracks = (uint16_t)grid->columnWidths.size();
+            node.rowTracks = (uint16_t)grid->rowHeights.size();
+            node.firstCoord = (uint32_t)coords.size();
+            coords.insert(coords.end(), grid->columnWidths.begin(), grid->columnWidths.end());
+
+            //min widths the layout didn't need are stored as LengthAuto, like those of the elements
+            if(grid->columnMinWidths.size() == grid->columnWidths.size()) {
+                coords.insert(coords.end(), grid->columnMinWidths.begin(), grid->columnMinWidths.end());
+            }
+            else {
+                coords.insert(coords.end(), grid->columnWidths.size(), (Coord)LengthAuto);
+            }
+            coords.insert(coords.end(), grid->rowHeights.begin(), grid->rowHeights.end());
+            coords.insert(coords.end(), grid->rowMinHeights.begin(), grid->rowMinHeights.end());
+            node.coordCount = (uint32_t)coords.size() - node.firstCoord;
+        }
+        else if(element->elementType == ElementTypeText) {
+            BasicText<Coord>* textElement = (BasicText<Coord>*)element;
+            node.text.offset = (uint32_t)strings.size();
+            node.firstLine = (uint32_t)lines.size();
+
+            //external text is copied in, the snapshot owns all of its strings. The lines stay spans into the copy so
+            //a tree copied back out wraps the text the same way, only a truncated last line needs its own copy to 
+            //hold the ellipsis.
+            if(textElement->textBuffer != nullptr) {
+                const char* buffer = textElement->textBuffer->data;
+                uint32_t textOffset = textElement->textSpan.offset;
+                node.externalText = true;
+                node.text.length = textElement->textSpan.length;
+                strings.append(buffer + textOffset, textElement->textSpan.length);
+
+                node.lineCount = (uint32_t)textElement->wrappedSpans.size();
+                for(size_t line = 0; line < textElement->wrappedSpans.size(); line++) {
+                    const TextSpan& span = textElement->wrappedSpans[line];
+                    lines.push_back(TextSpan{node.text.offset + (span.offset - textOffset), span.length});
+                }
+
+                if(textElement->truncated && node.lineCount > 0) {
+                    const TextSpan& kept = textElement->truncatedSpan;
+                    node.truncatedSpan = TextSpan{node.text.offset + (kept.offset - textOffset), kept.length};
+                    lines.back() = TextSpan{(uint32_t)strings.size(), kept.length + 3};
+                    strings.append(buffer + kept.offset, kept.length);
+                    strings.append("\xE2\x80\xA6");
+                }
+            }
+            else {
+                node.text.length = (uint32_t)textElement->text.size();
+                strings += textElement->text;
+
+                node.lineCount = (uint32_t)textElement->wrappedText.size();
+                for(size_t line = 0; line < textElement->wrappedText.size(); line++) {
+                    lines.push_back(TextSpan{(uint32_t)strings.size(), (uint32_t)textElement->wrappedText[line].size()});
+                    strings += textElement->wrappedText[line];
+                }
+
+                if(textElement->truncated) {
+                    const TextSpan& kept = textElement->truncatedSpan;
+                    node.truncatedSpan = TextSpan{node.text.offset + kept.offset, kept.length};
+                }
+            }
+
+            node.color = textElement->color;
+            node.textAlign = textElement->textAlign;
+            node.font = textElement->font;
+            node.maxLines = textElement->maxLines;
+            node.truncated = textElement->truncated;
+        }
+        else if(element->elementType == ElementTypePolygon) {
+            BasicPolygon<Coord>* polygon = (BasicPolygon<Coord>*)element;
+            node.firstCoord = (uint32_t)coords.size();
+            node.coordCount = (uint32_t)polygon->points.size();
+            coords.insert(coords.end(), polygon->points.begin(), polygon->points.end());
+            node.fill = polygon->fill;
+            node.stroke = polygon->stroke;
+        }
+
+        nodes.push_back(node);
+    }
+
+    //lay the sections out one after the other
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SnapshotMagic, sizeof(SnapshotMagic));
+    header.version = SnapshotVersion;
+    header.coordType = coordType<Coord>();
+    header.nodeSize = sizeof(BasicSnapshotNode<Coord>);
+    header.styleSize = sizeof(BasicStyle<Coord>);
+    header.styleCount = (uint32_t)styles.size();
+    header.nodeCount = (uint32_t)nodes.size();
+    header.lineCount = (uint32_t)lines.size();
+    header.coordCount = (uint32_t)coords.size();
+    header.stringsSize = (uint32_t)strings.size();
+
+    size_t offset = alignSection(sizeof(SnapshotHeader));
+    header.stylesOffset = (uint32_t)offset;
+    offset = alignSection(offset + styles.size() * sizeof(BasicStyle<Coord>));
+    header.nodesOffset = (uint32_t)offset;
+    offset = alignSection(offset + nodes.size() * sizeof(BasicSnapshotNode<Coord>));
+    header.linesOffset = (uint32_t)offset;
+    offset = alignSection(offset + lines.size() * sizeof(TextSpan));
+    header.coordsOffset = (uint32_t)offset;
+    offset = alignSection(offset + coords.size() * sizeof(Coord));
+    header.stringsOffset = (uint32_t)offset;
+    offset = alignSection(offset + strings.size());
+    header.totalSize = (uint32_t)offset;
+
+    snapshot.assign(offset, 0);
+    uint8_t* out = snapshot.data();
+    memcpy(out, &header, sizeof(header));
+    if(!styles.empty()) memcpy(out + header.stylesOffset, styles.data(), styles.size() * sizeof(BasicStyle<Coord>));
+    if(!nodes.empty()) memcpy(out + header.nodesOffset, nodes.data(), nodes.size() * sizeof(BasicSnapshotNode<Coord>));
+    if(!lines.empty()) memcpy(out + header.linesOffset, lines.data(), lines.size() * sizeof(TextSpan));
+    if(!coords.empty()) memcpy(out + header.coordsOffset, coords.data(), coords.size() * sizeof(Coord));
+    if(!strings.empty()) memcpy(out + header.stringsOffset, strings.data(), strings.size());
+}
+
+template<typename Coord>
+bool BasicSnapshot<Coord>::open(const void* data, size_t size) {
+    close();
+    this->data = (const uint8_t*)data;
+    this->size = size;
+
+    if(!validate()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+template<typename Coord>
+bool BasicSnapshot<Coord>::map(const char* path) {
+    close();
+
+    int fileDescriptor = ::open(path, O_RDONLY);
+    if(fileDescriptor < 0) {
+        return false;
+    }
+
+    struct stat fileStat;
+    void* mapped = MAP_FAILED;
+    if(fstat(fileDescriptor, &fileStat) == 0 && fileStat.st_size > 0) {
+        mapped = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    }
+    ::close(fileDescriptor);
+
+    if(mapped == MAP_FAILED) {
+        return false;
+    }
+
+    data = (const uint8_t*)mapped;
+    size = (size_t)fileStat.st_size;
+    mappedSize = size;
+
+    if(!validate()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+//Checks the header, that every section is inside the snapshot and that every index and span stays in its section
+template<typename Coord>
+bool BasicSnapshot<Coord>::validate() {
+
+    if(data == nullptr || size < sizeof(SnapshotHeader) || (uintptr_t)data % 8 != 0) {
+        return false;
+    }
+
+    const SnapshotHeader* header = (const SnapshotHeader*)data;
+    if(memcmp(header->magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0 || header->version != SnapshotVersion ||
+        header->coordType != coordType<Coord>() || header->nodeSize != sizeof(BasicSnapshotNode<Coord>) ||
+        header->styleSize != sizeof(BasicStyle<Coord>) || header->totalSize > size) {
+        return false;
+    }
+
+    if(!sectionFits(header->stylesOffset, header->styleCount, sizeof(BasicStyle<Coord>), header->totalSize) ||
+        !sectionFits(header->nodesOffset, header->nodeCount, sizeof(BasicSnapshotNode<Coord>), header->totalSize) ||
+        !sectionFits(header->linesOffset, header->lineCount, sizeof(TextSpan), header->totalSize) ||
+        !sectionFits(header->coordsOffset, header->coordCount, sizeof(Coord), header->totalSize) ||
+        !sectionFits(header->stringsOffset, header->stringsSize, 1, header->totalSize)) {
+        return false;
+    }
+
+    const BasicSnapshotNode<Coord>* nodes = (const BasicSnapshotNode<Coord>*)(data + header->nodesOffset);
+    const TextSpan* lines = (const TextSpan*)(data + header->linesOffset);
+
+    if(header->nodeCount == 0 || !isContainerType(nodes[0].elementType)) {
+        return false;
+    }
+
+    for(uint32_t i = 0; i < header->nodeCount; i++) {
+        const BasicSnapshotNode<Coord>& node = nodes[i];
+
+        if(node.style >= header->styleCount) {
+            return false;
+        }
+
+        //children always come after their parent, which also rules out cycles
+        if(node.childCount > 0 && (!isContainerType(node.elementType) || node.firstChild <= i ||
+            node.firstChild > header->nodeCount || node.childCount > header->nodeCount - node.firstChild)) {
+            return false;
+        }
+
+        if(node.elementType == ElementTypeText) {
+            if(!spanFits(node.text, header->stringsSize) || node.firstLine > header->lineCount ||
+                node.lineCount > header->lineCount - node.firstLine) {
+                return false;
+            }
+            for(uint32_t line = 0; line < node.lineCount; line++) {
+                if(!spanFits(lines[node.firstLine + line], header->stringsSize)) {
+                    return false;
+                }
+            }
+            if(node.truncated && (!spanFits(node.truncatedSpan, header->stringsSize) || 
+                node.truncatedSpan.offset < node.text.offset)) {
+                return false;
+            }
+        }
+
+        if(node.elementType == ElementTypeGrid && node.coordCount != 2u * node.columnTracks + 2u * node.rowTracks) {
+            return false;
+        }
+
+        if(node.firstCoord > header->coordCount || node.coordCount > header->coordCount - node.firstCoord) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename Coord>
+uint32_t BasicSnapshot<Coord>::getNodeCount() const {
+    return data != nullptr ? ((const SnapshotHeader*)data)->nodeCount : 0;
+}
+
+template<typename Coord>
+const BasicSnapshotNode<Coord>& BasicSnapshot<Coord>::getNode(uint32_t index) const {
+    const SnapshotHeader* header = (const SnapshotHeader*)data;
+    return ((const BasicSnapshotNode<Coord>*)(data + header->nodesOffset))[index];
+}
+
+template<typename Coord>
+const BasicStyle<Coord>& BasicSnapshot<Coord>::getStyle(uint32_t index) const {
+    const SnapshotHeader* header = (const SnapshotHeader*)data;
+    return ((const BasicStyle<Coord>*)(data + header->stylesOffset))[index];
+}
+
+template<typename Coord>
+const char* BasicSnapshot<Coord>::getString(TextSpan span) const {
+    const SnapshotHeader* header = (const SnapshotHeader*)data;
+    return (const char*)(data + header->stringsOffset + span.offset);
+}
+
+template<typename Coord>
+TextSpan BasicSnapshot<Coord>::getLine(uint32_t index) const {
+    const SnapshotHeader* header = (const SnapshotHeader*)data;
+    return ((const TextSpan*)(data + header->linesOffset))[index];
+}
+
+template<typename Coord>
+const Coord* BasicSnapshot<Coord>::getCoords(uint32_t firstCoord) const {
+    const SnapshotHeader* header = (const SnapshotHeader*)data;
+    return (const Coord*)(data + header->coordsOffset) + firstCoord;
+}
+
+template<typename Coord>
+BasicBaseElement<Coord>* BasicSnapshot<Coord>::copyElement(uint32_t index) const {
+
+    const BasicSnapshotNode<Coord>& node = getNode(index);
+    BasicBaseElement<Coord>* element = nullptr;
+
+    if(node.elementType == ElementTypeText) {
+        BasicText<Coord>* textElement = new BasicText<Coord>();
+        if(node.externalText) {
+            textElement->textBuffer = stringBuffer.get();
+            textElement->textSpan = node.text;
+            textElement->wrappedSpans.resize(node.lineCount);
+            for(uint32_t line = 0; line < node.lineCount; line++) {
+                textElement->wrappedSpans[line] = getLine(node.firstLine + line);
+            }
+
+            //the stored last line holds the ellipsis, the element's span is the text kept before it
+            if(node.truncated && node.lineCount > 0) {
+                textElement->wrappedSpans.back() = node.truncatedSpan;
+            }
+            textElement->truncatedSpan = node.truncatedSpan;
+        }
+        else {
+            textElement->text.assign(getString(node.text), node.text.length);
+            textElement->wrappedText.resize(node.lineCount);
+            for(uint32_t line = 0; line < node.lineCount; line++) {
+                TextSpan span = getLine(node.firstLine + line);
+                textElement->wrappedText[line].assign(getString(span), span.length);
+            }
+            if(node.truncated) {
+                textElement->truncatedSpan = TextSpan{node.truncatedSpan.offset - node.text.offset, node.truncatedSpan.length};
+            }
+        }
+        textElement->color = node.color;
+        textElement->textAlign = node.textAlign;
+        textElement->font = node.font;
+        textElement->maxLines = node.maxLines;
+        textElement->truncated = node.truncated;
+        element = textElement;
+    }
+    else if(node.elementType == ElementTypePolygon) {
+        BasicPolygon<Coord>* polygon = new BasicPolygon<Coord>();
+        const Coord* points = getCoords(node.firstCoord);
+        polygon->points.assign(points, points + node.coordCount);
+        polygon->fill = node.fill;
+        polygon->stroke = node.stroke;
+        element = polygon;
+    }
+    else {
+        BasicContainer<Coord>* container;
+        if(node.elementType == ElementTypeGrid) {
+            BasicGrid<Coord>* grid = new BasicGrid<Coord>();
+            const Coord* tracks = getCoords(node.firstCoord);
+            grid->columnCount = node.columnCount;
+            grid->columnWidths.assign(tracks, tracks + node.columnTracks);
+            tracks += node.columnTracks;
+            if(node.columnTracks > 0 && tracks[0] >= 0) {
+                grid->columnMinWidths.assign(tracks, tracks + node.columnTracks);
+            }
+            tracks += node.columnTracks;
+            grid->rowHeights.assign(tracks, tracks + node.rowTracks);
+            tracks += node.rowTracks;
+            grid->rowMinHeights.assign(tracks, tracks + node.rowTracks);
+            container = grid;
+        }
+        else {
+            container = new BasicContainer<Coord>();
+        }
+
+        container->children.reserve(node.childCount);
+        for(uint32_t i = 0; i < node.childCount; i++) {
+            container->children.push_back(copyElement(node.firstChild + i));
+        }
+        element = container;
+    }
+
+    element->layout = node.layout;
+    element->width = node.width;
+    element->height = node.height;
+    element->maxWidth = node.maxWidth;
+    element->maxHeight = node.maxHeight;
+    element->minWidth = node.minWidth;
+    element->minHeight = node.minHeight;
+    element->style = internStyle<Coord>(getStyle(node.style));
+    element->grow = node.grow;
+    element->zIndex = node.zIndex;
+    element->positioning = node.positioning;
+    element->visible = node.visible;
+    element->displayed = node.displayed;
+    return element;
+}
+
+template<typename Coord>
+BasicContainer<Coord>* BasicSnapshot<Coord>::copyToTree() const {
+    if(data == nullptr) {
+        return nullptr;
+    }
+
+    //external text of every copy shows the string pool in place
+    {
+        std::lock_guard<std::mutex> lock(stringBufferMutex);
+        if(!stringBuffer) {
+            const SnapshotHeader* header = (const SnapshotHeader*)data;
+            stringBuffer.reset(new TextBuffer((const char*)(data + header->stringsOffset), header->stringsSize));
+        }
+    }
+    return (BasicContainer<Coord>*)copyElement(0);
+}
+
+//
+//Layout publishing. The back buffer is the first one that only the publisher holds, or a new one when every buffer is 
+//still held by a reader or is the front. Handles share ownership of their buffer, so nothing is allocated per publish.
+//
+
+template<typename Coord>
+BasicLayoutPublisher<Coord>::BasicLayoutPublisher() {
+    publishedCount = 0;
+}
+
+template<typename Coord>
+void BasicLayoutPublisher<Coord>::layoutAndPublish(BasicContainer<Coord>* root, BasicMeasurementContext<Coord>* measurementContext, 
+    LayoutContext* layoutContext) {
+    layout(root, measurementContext, layoutContext);
+    publish(root);
+}
+
+template<typename Coord>
+void BasicLayoutPublisher<Coord>::publish(BasicContainer<Coord>* root) {
+
+    //the front is held by front itself, so it is never picked while it can still be acquired
+    std::shared_ptr<Buffer> buffer;
+    for(size_t i = 0; i < buffers.size(); i++) {
+        if(buffers[i].use_count() == 1) {
+            buffer = buffers[i];
+            break;
+        }
+    }
+    if(buffer) {
+        //the count was read relaxed, this orders it after the last reader's release of the buffer
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    else {
+        buffer = std::make_shared<Buffer>();
+        buffers.push_back(buffer);
+    }
+
+    //the bytes and the scratch keep their capacity from the last frame written with them
+    BasicSnapshot<Coord>::write(root, buffer->bytes, buffer->scratch);
+    buffer->snapshot.open(buffer->bytes.data(), buffer->bytes.size());
+
+    //the old front is free again once the last reader lets go of it
+    std::atomic_store(&front, Handle(buffer, &buffer->snapshot));
+    publishedCount++;
+}
+
+template<typename Coord>
+typename BasicLayoutPublisher<Coord>::Handle BasicLayoutPublisher<Coord>::acquire() const {
+    return std::atomic_load(&front);
+}
+
+template<typename Coord>
+uint64_t BasicLayoutPublisher<Coord>::getPublishedCount() const {
+    return publishedCount;
+}
+
+template class BasicSnapshot<int16_t>;
+template class BasicSnapshot<int32_t>;
+template class BasicSnapshot<float>;
+template class BasicLayoutPublisher<int16_t>;
+template class BasicLayoutPublisher<int32_t>;
+template class BasicLayoutPublisher<float>;
+
+} // namespace TinyLayoutEngine
\ No newline at end of file
@@ -0,0 +1,170 @@
+#ifndef TINY_LAYOUT_ENGINE_SNAPSHOT_HPP
+#define TINY_LAYOUT_ENGINE_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+#include "tinyLayoutEngine.hpp"
+
+namespace TinyLayoutEngine {
+
+//One element of a snapshot. Elements are stored breadth first so the children of an element are next to each other,
+//everything else is referenced by index into the other sections of the snapshot.
+template<typename Coord>
+struct BasicSnapshotNode {
+    BasicComputedLayout<Coord> layout;
+
+    Coord width;
+    Coord height;
+    Coord maxWidth;
+    Coord maxHeight;
+    Coord minWidth;
+    Coord minHeight;
+
+    uint32_t style; // Index into the snapshot's styles
+    uint32_t firstChild; // Index of the first child, children are consecutive
+    uint32_t childCount;
+
+    TextSpan text; // Text content, in the string pool
+    uint32_t firstLine; // Wrapped lines of a text, in the line spans
+    uint32_t lineCount;
+    TextSpan truncatedSpan; // The text kept before the ellipsis, in the string pool
+
+    uint32_t firstCoord; // Points of a polygon, or the column widths, column min widths, row heights and row min heights of a grid
+    uint32_t coordCount;
+
+    Color color; // Text color
+    uint16_t columnCount; // Grid column count as set on the grid
+    uint16_t columnTracks; // Number of resolved grid columns and rows
+    uint16_t rowTracks;
+    uint16_t maxLines; // Line limit of a text
+
+    int8_t grow;
+    int8_t zIndex;
+    ElementType elementType;
+    Positioning positioning;
+    TextAlignment textAlign;
+    uint8_t font;
+    bool visible;
+    bool displayed;
+    bool fill;
+    bool stroke;
+    bool truncated; // The text was cut, its last line ends in an ellipsis
+    bool externalText; // The text was shown from a TextBuffer, its lines are spans into the text
+};
+
+//A laid out tree stored as one position independent block of memory: styles, elements, text, wrapped lines, polygon
+//points, grid tracks and the computed layouts. A snapshot can be written to a file, mapped back in by another process
+//and read in place without deserializing, or copied into a mutable tree to keep editing it.
+template<typename Coord>
+class BasicSnapshot {
+public:
+
+    BasicSnapshot();
+    ~BasicSnapshot();
+    BasicSnapshot(const BasicSnapshot&) = delete;
+    BasicSnapshot& operator=(const BasicSnapshot&) = delete;
+
+    //Buffers write gathers the sections in before copying them into the snapshot. Keep one to write the same tree
+    //again without allocating, the buffers keep their capacity.
+    struct WriteScratch {
+        std::vector<BasicBaseElement<Coord>*> elements;
+        std::vector<BasicSnapshotNode<Coord>> nodes;
+        std::vector<BasicStyle<Coord>> styles;
+        std::vector<StyleHandle> styleHandles; // Handle of each of the styles
+        std::vector<uint32_t> styleIndices; // Index in styles by style handle, only valid where styleHandles points back
+        std::vector<TextSpan> lines;
+        std::vector<Coord> coords;
+        std::string strings;
+    };
+
+    //Writes a laid out tree into a snapshot
+    static void write(BasicContainer<Coord>* root, std::vector<uint8_t>& snapshot);
+    static void write(BasicContainer<Coord>* root, std::vector<uint8_t>& snapshot, WriteScratch& scratch);
+
+    //Uses a snapshot already in memory, it must stay alive and unchanged while in use. Returns false if it is
+    //not a valid snapshot for this coordinate type.
+    bool open(const void* data, size_t size);
+
+    //Maps a snapshot file read only, native builds only
+    bool map(const char* path);
+
+    //Read only access, only valid after open or map succeeded. The root is element 0.
+    uint32_t getNodeCount() const;
+    const BasicSnapshotNode<Coord>& getNode(uint32_t index) const;
+    const BasicStyle<Coord>& getStyle(uint32_t index) const;
+    const char* getString(TextSpan span) const; // Not null terminated, span.length characters
+    TextSpan getLine(uint32_t index) const;
+    const Coord* getCoords(uint32_t firstCoord) const;
+
+    //Copies the snapshot into new elements, the styles are interned. Returns nullptr if nothing is open. Text that
+    //was external is copied as external text again, showing spans of a TextBuffer the snapshot owns, so it wraps
+    //exactly as it did. The copy must be destroyed before the snapshot is closed, reopened or destroyed.
+    BasicContainer<Coord>* copyToTree() const;
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t mappedSize; // Non zero when the memory is a mapping owned by this snapshot
+    mutable std::unique_ptr<TextBuffer> stringBuffer; // The string pool as a TextBuffer, made by the first copyToTree
+    mutable std::mutex stringBufferMutex;
+
+    void close();
+    bool validate();
+    BasicBaseElement<Coord>* copyElement(uint32_t index) const;
+};
+
+//Double buffered layout results, so a layout thread and a render thread don't have to share a lock. Each layout is 
+//written into a back buffer as a snapshot and published with an atomic swap, readers take the front one without 
+//blocking the layout and can keep it across as many frames as they like. Buffers are reused once every handle to them
+//is released, so a renderer that keeps up only ever needs two, and a publish into a reused buffer doesn't allocate 
+//once the buffer has held a frame as large. Native builds only, like the snapshots.
+//Only the snapshots are double buffered, the layout still writes the layout fields of the tree's elements in place. 
+//Render threads must read the published snapshot and never the elements while a layout can run.
+template<typename Coord>
+class BasicLayoutPublisher {
+public:
+    typedef std::shared_ptr<const BasicSnapshot<Coord>> Handle;
+
+    BasicLayoutPublisher();
+    BasicLayoutPublisher(const BasicLayoutPublisher&) = delete;
+    BasicLayoutPublisher& operator=(const BasicLayoutPublisher&) = delete;
+
+    //Lays the tree out and publishes the results, from the layout thread
+    void layoutAndPublish(BasicContainer<Coord>* root, BasicMeasurementContext<Coord>* measurementContext, LayoutContext* layoutContext);
+
+    //Publishes a tree that is already laid out, from the layout thread
+    void publish(BasicContainer<Coord>* root);
+
+    //The last published results, empty before the first publish. Safe from any thread, the handle stays valid and 
+    //unchanged however many layouts are published after it.
+    Handle acquire() const;
+
+    //Number of layouts published so far
+    uint64_t getPublishedCount() const;
+
+private:
+    struct Buffer {
+        std::vector<uint8_t> bytes;
+        typename BasicSnapshot<Coord>::WriteScratch scratch;
+        BasicSnapshot<Coord> snapshot; // Opened on bytes
+    };
+
+    //Every buffer made so far, the handles share ownership of them. A buffer nothing else holds is free to write, 
+    //only the layout thread touches the list.
+    std::vector<std::shared_ptr<Buffer>> buffers;
+    Handle front; // Only read and written with the atomic shared_ptr functions
+    std::atomic<uint64_t> publishedCount;
+};
+
+typedef BasicSnapshot<int16_t> Snapshot;
+typedef BasicSnapshotNode<int16_t> SnapshotNode;
+typedef BasicLayoutPublisher<int16_t> LayoutPublisher;
+
+} // namespace TinyLayoutEngine
+
+#endif // TINY_LAYOUT_ENGINE_SNAPSHOT_HPP
\ No newline at end of file
@@ -34,7 +34,8 @@ EMSCRIPTEN_BINDINGS(TinyLayoutEngine_bindings) {
     enum_<ElementType>("ElementType")
         .value("ElementTypeContainer", ElementTypeContainer)
         .value("ElementTypeText",      ElementTypeText)
-        .value("ElementTypePolygon",   ElementTypePolygon);
+        .value("ElementTypePolygon",   ElementTypePolygon)
+        .value("ElementTypeGrid",      ElementTypeGrid);
 
     enum_<Positioning>("Positioning")
         .value("PositionFree",   PositionFree)
@@ -88,7 +89,37 @@ EMSCRIPTEN_BINDINGS(TinyLayoutEngine_bindings) {
         .field("minWidth", &ComputedLayout::minWidth)
         .field("minHeight",&ComputedLayout::minHeight)
         .field("width",    &ComputedLayout::width)
-        .field("height",   &ComputedLayout::height);
+        .field("height",   &ComputedLayout::height)
+        .field("fitWidth", &ComputedLayout::fitWidth)
+        .field("fitHeight",&ComputedLayout::fitHeight);
+
+    value_object<Style>("Style")
+        .field("borderWidth",     &Style::borderWidth)
+        .field("borderRadius",    &Style::borderRadius)
+        .field("paddingLeft",     &Style::paddingLeft)
+        .field("paddingRight",    &Style::paddingRight)
+        .field("paddingTop",      &Style::paddingTop)
+        .field("paddingBottom",   &Style::paddingBottom)
+        .field("marginLeft",      &Style::marginLeft)
+        .field("marginRight",     &Style::marginRight)
+        .field("marginTop",       &Style::marginTop)
+        .field("marginBottom",    &Style::marginBottom)
+        .field("gap",             &Style::gap)
+        .field("backgroundColor", &Style::backgroundColor)
+        .field("borderColor",     &Style::borderColor)
+        .field("alignSelf",       &Style::alignSelf)
+        .field("alignItems",      &Style::alignItems)
+        .field("justifyContent",  &Style::justifyContent)
+        .field("layoutDirection", &Style::layoutDirection)
+        .field("overflow",        &Style::overflow);
+
+    //
+    // Style table
+    //
+    function("internStyle", &internStyle<int16_t>);
+    function("createStyle", &createStyle<int16_t>);
+    function("setStyle",    &setStyle<int16_t>);
+    function("getStyle",    optional_override([](StyleHandle handle) { return *getStyle(handle); }));
 
     //
     // std::vector registrations
@@ -96,6 +127,12 @@ EMSCRIPTEN_BINDINGS(TinyLayoutEngine_bindings) {
     register_vector<BaseElement*>("BaseElementPtrVector");
     register_vector<std::string>("StringVector");
     register_vector<int16_t>("Int16Vector");
+    register_vector<TextSpan>("TextSpanVector");
+    register_vector<uint32_t>("Uint32Vector");
+
+    value_object<TextSpan>("TextSpan")
+        .field("offset", &TextSpan::offset)
+        .field("length", &TextSpan::length);
 
     //
     // BaseElement
@@ -104,9 +141,6 @@ EMSCRIPTEN_BINDINGS(TinyLayoutEngine_bindings) {
         .constructor<>()
         .property("layout",        &BaseElement::layout)
 
-        .property("borderWidth",   &BaseElement::borderWidth)
-        .property("borderRadius",  &BaseElement::borderRadius)
-
         .property("width",         &BaseElement::width)
         .property("height",        &BaseElement::height)
         .property("maxWidth",      &BaseElement::maxWidth)
@@ -114,25 +148,13 @@ EMSCRIPTEN_BINDINGS(TinyLayoutEngine_bindings) {
         .property("minWidth",      &BaseElement::minWidth)
         .property("minHeight",     &BaseElement::minHeight)
 
-        .property("paddingLeft",   &BaseElement::paddingLeft)
-        .property("paddingRight",  &BaseElement::paddingRight)
-        .property("paddingTop",    &BaseElement::paddingTop)
-        .property("paddingBottom", &BaseElement::paddingBottom)
-
-        .property("marginLeft",    &BaseElement::marginLeft)
-        .property("marginRight",   &BaseElement::marginRight)
-        .property("marginTop",     &BaseElement::marginTop)
-        .property("marginBottom",  &BaseElement::marginBottom)
+        .property("style",         &BaseElement::style)
 
         .property("grow",          &BaseElement::grow)
         .property("zIndex",        &BaseElement::zIndex)
 
-        .property("backgroundColor",&BaseElement::backgroundColor)
-        .property("borderColor",    &BaseElement::borderColor)
-
         .property("elementType",   &BaseElement::elementType)
         .property("positioning",   &BaseElement::positioning)
-        .property("alignSelf",     &BaseElement::alignSelf)
 
         .property("visible",       &BaseElement::visible)
         .property("displayed",     &BaseElement::displayed)
@@ -144,11 +166,18 @@ EMSCRIPTEN_BINDINGS(TinyLayoutEngine_bindings) {
     class_<Container, base<BaseElement>>("Container")
         .constructor<>()
         .property("children",      &Container::children)
-        .property("gap",           &Container::gap)
-        .property("overflow",      &Container::overflow)
-        .property("layoutDirection",&Container::layoutDirection)
-        .property("justifyContent",&Container::justifyContent)
-        .property("alignItems",    &Container::alignItems)
+        ;
+
+    //
+    // Grid
+    //
+    class_<Grid, base<Container>>("Grid")
+        .constructor<>()
+        .property("columnCount",     &Grid::columnCount)
+        .property("columnWidths",    &Grid::columnWidths)
+        .property("columnMinWidths", &Grid::columnMinWidths)
+        .property("rowHeights",      &Grid::rowHeights)
+        .property("rowMinHeights",   &Grid::rowMinHeights)
         ;
 
     //
@@ -161,6 +190,20 @@ EMSCRIPTEN_BINDINGS(TinyLayoutEngine_bindings) {
         .property("color",       &Text::color)
         .property("textAlign",   &Text::textAlign)
         .property("font",        &Text::font)
+        .property("textSpan",    &Text::textSpan)
+        .property("wrappedSpans", &Text::wrappedSpans)
+        .property("maxLines",    &Text::maxLines)
+        .property("truncated",   &Text::truncated)
+        .property("truncatedSpan", &Text::truncatedSpan)
+        .function("setTextBuffer", optional_override([](Text& text, TextBuffer* textBuffer) { text.textBuffer = textBuffer; }), allow_raw_pointers())
+        ;
+
+    //
+    // TextBuffer, text written into the WASM heap by JS and shown by text elements without a copy
+    //
+    class_<TextBuffer>("TextBuffer")
+        .constructor(optional_override([](uintptr_t data, size_t size) { return new TextBuffer((const char*)data, size); }))
+        .property("size", &TextBuffer::size)
         ;
 
     //
@@ -171,6 +214,9 @@ EMSCRIPTEN_BINDINGS(TinyLayoutEngine_bindings) {
         .property("points", &Polygon::points)
         .property("fill",   &Polygon::fill)
         .property("stroke", &Polygon::stroke)
+        .property("boxPoints",      &Polygon::boxPoints)
+        .property("fillTriangles",  &Polygon::fillTriangles)
+        .property("strokeOutline",  &Polygon::strokeOutline)
         ;
 
     //
@@ -182,8 +228,62 @@ EMSCRIPTEN_BINDINGS(TinyLayoutEngine_bindings) {
     class_<BaseMeasurementContext>("BaseMeasurementContext")
         .allow_subclass<BaseMeasurementContextWrapper>("BaseMeasurementContextWrapper");
 
+    //
+    // LayoutContext, scratch buffers reused between layout calls
+    //
+    class_<LayoutContext>("LayoutContext")
+        .constructor<>()
+        ;
+
+    //
+    // LayoutJob, time sliced layout, run one slice per frame
+    //
+    enum_<LayoutStatus>("LayoutStatus")
+        .value("LayoutIncomplete", LayoutIncomplete)
+        .value("LayoutComplete",   LayoutComplete)
+        .value("LayoutCancelled",  LayoutCancelled)
+        .value("LayoutWaiting",    LayoutWaiting);
+
+    class_<LayoutJob>("LayoutJob")
+        .constructor<Container*, BaseMeasurementContext*, LayoutContext*>(allow_raw_pointers())
+        .function("run", &LayoutJob::run)
+        .function("restart", &LayoutJob::restart)
+        .function("cancel", &LayoutJob::cancel)
+        .function("getStatus", &LayoutJob::getStatus)
+        ;
+
+    //
+    // AsyncLayout, measurements are answered in batches from JS, e.g. by a Web Worker
+    //
+    value_object<MeasurementRequest>("MeasurementRequest")
+        .field("text",         &MeasurementRequest::text)
+        .field("font",         &MeasurementRequest::font)
+        .field("lineSpacing",  &MeasurementRequest::lineSpacing)
+        .field("isLineHeight", &MeasurementRequest::isLineHeight);
+
+    class_<AsyncLayout>("AsyncLayout")
+        .constructor<Container*, LayoutContext*>(allow_raw_pointers())
+        .function("run", &AsyncLayout::run)
+        .function("getPendingRequestCount", optional_override([](AsyncLayout& asyncLayout) { return asyncLayout.getPendingRequests().size(); }))
+        //an index past the pending requests returns an empty request and a resolve of one is ignored, JS can't be
+        //trusted to keep the count it was given
+        .function("getPendingRequest", optional_override([](AsyncLayout& asyncLayout, size_t index) {
+            const std::vector<MeasurementRequest>& requests = asyncLayout.getPendingRequests();
+            return index < requests.size() ? requests[index] : MeasurementRequest();
+        }))
+        .function("resolveRequest", optional_override([](AsyncLayout& asyncLayout, size_t index, int16_t result) {
+            if(index < asyncLayout.getPendingRequests().size()) {
+                asyncLayout.resolveRequest(index, result);
+            }
+        }))
+        .function("clearCache", &AsyncLayout::clearCache)
+        ;
+
     //
     // Free function: layout
     //
-    function("layout", &layout, allow_raw_pointers());
+    function("layout", select_overload<void(Container*, BaseMeasurementContext*)>(&layout), allow_raw_pointers());
+    function("layoutWithContext", select_overload<void(Container*, BaseMeasurementContext*, LayoutContext*)>(&layout), allow_raw_pointers());
+    function("layoutAppended", &layoutAppended<int16_t>, allow_raw_pointers());
+    function("resolveMinWidth", &resolveMinWidth<int16_t>, allow_raw_pointers());
 }
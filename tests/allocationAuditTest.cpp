@@ -0,0 +1,148 @@
+//Checks that a warm layout doesn't touch the heap. Linked with tinyLayoutEngineAllocationAudit.cpp, which counts
+//every allocation made while the audited layout runs. The tree covers the paths with their own scratch: wrapped and
+//truncated text, a grid, a container wide enough for the lane path and polygons with fill and stroke.
+
+#include <cstdio>
+#include <string>
+
+#include "tinyLayoutEngine.hpp"
+
+using namespace TinyLayoutEngine;
+
+namespace {
+
+//fixed advances so the test doesn't need fonts
+class TestMeasurementContext: public BaseMeasurementContext {
+public:
+    int16_t measureTextWidth(std::string& str, uint8_t font) override {
+        int width = 0;
+        for(char c: str) width += c == ' ' ? 4 : 5 + (c % 4);
+        return (int16_t)(width * (font + 1));
+    }
+
+    int16_t getLineHeight(int16_t lineSpacing, uint8_t font) override {
+        return (int16_t)(12 + font + lineSpacing);
+    }
+};
+
+Text* createText(const std::string& text, uint8_t font) {
+    Text* textElement = new Text();
+    textElement->text = text;
+    textElement->font = font;
+    return textElement;
+}
+
+Polygon* createPolygon(bool fill, bool stroke) {
+    Polygon* polygon = new Polygon();
+    polygon->points = {0, 0, 40, 0, 50, 30, 20, 45, 0, 30};
+    polygon->fill = fill;
+    polygon->stroke = stroke;
+    polygon->width = 60;
+    polygon->height = 40;
+    return polygon;
+}
+
+Container* createTree() {
+    Style columnStyle;
+    columnStyle.layoutDirection = LayoutColumn;
+    columnStyle.gap = 4;
+    columnStyle.paddingLeft = 8;
+    columnStyle.paddingRight = 8;
+
+    Style rowStyle;
+    rowStyle.gap = 3;
+
+    Style hiddenStyle;
+    hiddenStyle.overflow = OverflowHide;
+    hiddenStyle.alignSelf = AlignStart;
+
+    Style gridStyle;
+    gridStyle.gap = 2;
+    gridStyle.borderWidth = 1;
+
+    Container* root = new Container();
+    root->style = internStyle(columnStyle);
+    root->width = 420;
+
+    //wrapped text in a row that has to shrink
+    Container* row = new Container();
+    row->style = internStyle(rowStyle);
+    for(int i = 0; i < 3; i++) {
+        Text* text = createText("the quick brown fox jumps over the lazy dog " + std::to_string(i), (uint8_t)(i % 2));
+        text->grow = 1;
+        row->children.push_back(text);
+    }
+    root->children.push_back(row);
+
+    //truncated text, cut by maxLines and by a word too wide for the box
+    Text* truncated = createText("a paragraph that is far too long to fit in the two lines it is allowed to take up", 0);
+    truncated->style = internStyle(hiddenStyle);
+    truncated->maxLines = 2;
+    truncated->width = 120;
+    root->children.push_back(truncated);
+
+    Text* wideWord = createText("incomprehensibilities", 1);
+    wideWord->style = truncated->style;
+    wideWord->maxLines = 1;
+    wideWord->width = 60;
+    root->children.push_back(wideWord);
+
+    //a grid of text cells
+    Grid* grid = new Grid();
+    grid->style = internStyle(gridStyle);
+    grid->columnCount = 3;
+    for(int i = 0; i < 9; i++) {
+        grid->children.push_back(createText(i % 2 ? "cell" : "a longer grid cell", 0));
+    }
+    root->children.push_back(grid);
+
+    //a wide row that goes through the lane path
+    Container* wide = new Container();
+    wide->style = internStyle(rowStyle);
+    for(int i = 0; i < 80; i++) {
+        Container* child = new Container();
+        child->width = (int16_t)(3 + i % 5);
+        child->height = 10;
+        child->grow = (int8_t)(i % 3);
+        wide->children.push_back(child);
+    }
+    root->children.push_back(wide);
+
+    //polygons with every geometry kind
+    Container* shapes = new Container();
+    shapes->style = internStyle(rowStyle);
+    shapes->children.push_back(createPolygon(true, false));
+    shapes->children.push_back(createPolygon(false, true));
+    shapes->children.push_back(createPolygon(true, true));
+    root->children.push_back(shapes);
+
+    return root;
+}
+
+} // namespace
+
+int main() {
+    TestMeasurementContext measurementContext;
+    LayoutContext layoutContext;
+    Container* root = createTree();
+
+    size_t allocations = auditLayoutAllocations(root, &measurementContext, &layoutContext);
+
+    //make sure the tree really went through the paths it is meant to cover
+    Text* truncated = (Text*)root->children[1];
+    Text* wideWord = (Text*)root->children[2];
+    bool covered = truncated->truncated && truncated->wrappedText.size() == 2 && wideWord->truncated;
+
+    destroyElement<int16_t>(root);
+
+    if(!covered) {
+        fprintf(stderr, "allocation audit: the test tree didn't truncate its text\n");
+        return 1;
+    }
+    if(allocations != 0) {
+        fprintf(stderr, "allocation audit: warm layout made %zu allocations\n", allocations);
+        return 1;
+    }
+    printf("allocation audit: warm layout made no allocations\n");
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,441 @@
+//Lays out a seeded corpus of random trees and compares every element's box against a golden file, so changes to the
+//sizing kernels show up as diffs. A change that is meant to move boxes regenerates the file with --update and the
+//commit explains the diff. A few directed cases below pin the behavior the corpus alone doesn't make obvious.
+//
+//Usage: layoutCorpusTest <golden file> [--update]
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tinyLayoutEngine.hpp"
+
+using namespace TinyLayoutEngine;
+
+namespace {
+
+const int CorpusTreeCount = 300;
+const uint32_t CorpusSeed = 1234;
+
+//fixed advances so the corpus doesn't need fonts
+class TestMeasurementContext: public BaseMeasurementContext {
+public:
+    int16_t measureTextWidth(std::string& str, uint8_t font) override {
+        int width = 0;
+        for(char c: str) width += c == ' ' ? 4 : 5 + (c % 4);
+        return (int16_t)(width * (font + 1));
+    }
+
+    int16_t getLineHeight(int16_t, uint8_t font) override {
+        return (int16_t)(12 + font);
+    }
+};
+
+class CorpusGenerator {
+public:
+    CorpusGenerator(): random(CorpusSeed) {
+        for(int i = 0; i < 20; i++) {
+            Style style;
+            style.paddingLeft = (int16_t)pick(5);
+            style.paddingRight = (int16_t)pick(5);
+            style.paddingTop = (int16_t)pick(5);
+            style.borderWidth = (int16_t)pick(3);
+            style.gap = (int16_t)pick(6);
+            style.layoutDirection = pick(2) ? LayoutRow : LayoutColumn;
+            style.alignItems = (Alignment)pick(4);
+            style.alignSelf = pick(2) ? AlignStretch : AlignStart;
+            styles.push_back(internStyle(style));
+        }
+    }
+
+    Container* createTree() {
+        Container* root = new Container();
+        root->width = (int16_t)(200 + pick(600));
+        root->height = 500;
+        root->layout.x = 0; //the root's position is the caller's, the layout places everything under it
+        root->layout.y = 0;
+        root->children.push_back(createElement(0));
+        root->children.push_back(createElement(1));
+        return root;
+    }
+
+private:
+    std::mt19937 random;
+    std::vector<StyleHandle> styles;
+
+    int pick(int count) {
+        return (int)(random() % count);
+    }
+
+    BaseElement* createElement(int depth) {
+        static const char* words[] = {"a", "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "x", "wide-word-here"};
+
+        if(depth > 3 || pick(3) == 0) {
+            Text* text = new Text();
+            int wordCount = pick(8);
+            for(int i = 0; i < wordCount; i++) {
+                if(i > 0) text->text += " ";
+                text->text += words[pick(9)];
+            }
+            text->font = (uint8_t)pick(2);
+            text->grow = (int8_t)pick(3);
+            text->style = styles[pick((int)styles.size())];
+            if(pick(5) == 0) text->width = (int16_t)pick(100);
+            return text;
+        }
+
+        Container* container;
+        if(pick(8) == 0) {
+            Grid* grid = new Grid();
+            grid->columnCount = (uint16_t)(1 + pick(3));
+            container = grid;
+        }
+        else {
+            container = new Container();
+        }
+        container->style = styles[pick((int)styles.size())];
+        container->grow = (int8_t)pick(3);
+        if(pick(6) == 0) container->width = (int16_t)pick(300);
+
+        int childCount = pick(6);
+        for(int i = 0; i < childCount; i++) container->children.push_back(createElement(depth + 1));
+        return container;
+    }
+};
+
+//one line per element in pre-order, the box, the min sizes and the number of wrapped lines of a text
+void writeElement(BaseElement* element, std::ostream& out) {
+    const ComputedLayout& layout = element->layout;
+    out << layout.x << ' ' << layout.y << ' ' << layout.width << ' ' << layout.height << ' ' << layout.minWidth << ' ' << layout.minHeight;
+    if(element->elementType == ElementTypeText) out << ' ' << ((Text*)element)->wrappedText.size();
+    out << '\n';
+
+    if(isContainerType(element->elementType)) {
+        for(BaseElement* child: ((Container*)element)->children) writeElement(child, out);
+    }
+}
+
+std::string layoutCorpus() {
+    CorpusGenerator generator;
+    TestMeasurementContext measurementContext;
+    LayoutContext layoutContext;
+    std::ostringstream out;
+
+    for(int i = 0; i < CorpusTreeCount; i++) {
+        Container* root = generator.createTree();
+        layout(root, &measurementContext, &layoutContext);
+        out << "tree " << i << '\n';
+        writeElement(root, out);
+        destroyElement<int16_t>(root);
+    }
+    return out.str();
+}
+
+//reports the first line that differs, the rest usually follows from it
+bool compareCorpus(const std::string& expected, const std::string& actual) {
+    std::istringstream expectedLines(expected);
+    std::istringstream actualLines(actual);
+    std::string expectedLine, actualLine, tree;
+    int lineNumber = 0;
+
+    while(true) {
+        bool haveExpected = (bool)std::getline(expectedLines, expectedLine);
+        bool haveActual = (bool)std::getline(actualLines, actualLine);
+        lineNumber++;
+        if(!haveExpected && !haveActual) return true;
+        if(haveActual && actualLine.compare(0, 5, "tree ") == 0) tree = actualLine;
+
+        if(haveExpected != haveActual || expectedLine != actualLine) {
+            fprintf(stderr, "layout corpus: line %d (%s) is '%s', expected '%s'\n", lineNumber, tree.c_str(), 
+                haveActual ? actualLine.c_str() : "<end>", haveExpected ? expectedLine.c_str() : "<end>");
+            return false;
+        }
+    }
+}
+
+//
+//Directed cases. The axis kernels replaced copies that had drifted apart, these pin what the copies got wrong.
+//
+
+bool check(bool condition, const char* what) {
+    if(!condition) fprintf(stderr, "layout corpus: %s\n", what);
+    return condition;
+}
+
+//a text with a set height takes exactly that height, padding doesn't come on top of it
+bool checkTextHeight() {
+    Style padded;
+    padded.paddingTop = 6;
+    padded.paddingBottom = 4;
+
+    Container root;
+    root.layout.x = 0;
+    root.layout.y = 0;
+    root.width = 300;
+    Text* text = new Text();
+    text->text = "lorem ipsum";
+    text->style = internStyle(padded);
+    text->height = 40;
+    root.children.push_back(text);
+
+    TestMeasurementContext measurementContext;
+    layout(&root, &measurementContext);
+    bool passed = check(text->layout.height == 40, "a set text height has padding added to it");
+    destroyElement<int16_t>(text);
+    root.children.clear();
+    return passed;
+}
+
+//grown widths survive the height passes and the heights are fitted to the wrapped text of those widths
+bool checkGrownHeights() {
+    Style column;
+    column.layoutDirection = LayoutColumn;
+
+    Container root;
+    root.layout.x = 0;
+    root.layout.y = 0;
+    root.width = 200;
+    root.style = internStyle(column);
+    Container* row = new Container();
+    root.children.push_back(row);
+    Text* text = new Text();
+    text->text = "lorem ipsum dolor sit amet consectetur lorem ipsum dolor sit amet";
+    text->grow = 1;
+    row->children.push_back(text);
+
+    TestMeasurementContext measurementContext;
+    layout(&root, &measurementContext);
+    int16_t lineHeight = measurementContext.getLineHeight(1, 0);
+    bool passed = check(text->layout.width == 200, "a grown text width is reset by the height pass");
+    passed = check(text->wrappedText.size() > 1, "the text isn't wrapped to its grown width") && passed;
+    passed = check(text->layout.height == (int16_t)(lineHeight * text->wrappedText.size()), 
+        "the text height doesn't follow its wrapped lines") && passed;
+    passed = check(row->layout.height == text->layout.height, "the row height isn't fitted to its child") && passed;
+    destroyElement<int16_t>(row);
+    root.children.clear();
+    return passed;
+}
+
+//
+//Incremental layouts. layoutAppended and the breakpoint layout promise the same result as layout() on the whole tree,
+//these hold them to it on the corpus trees.
+//
+
+class TestMeasurementContextFactory: public MeasurementContextFactory {
+public:
+    BaseMeasurementContext* createContext() override {
+        return new TestMeasurementContext();
+    }
+};
+
+//the plain columns with at least two children, in pre-order
+void findColumns(BaseElement* element, std::vector<Container*>& columns) {
+    if(!isContainerType(element->elementType)) return;
+    Container* container = (Container*)element;
+    if(container->elementType == ElementTypeContainer && container->children.size() >= 2 && 
+        getStyle<int16_t>(container->style)->layoutDirection == LayoutColumn) {
+        columns.push_back(container);
+    }
+    for(BaseElement* child: container->children) findColumns(child, columns);
+}
+
+//in turn for each column of a tree, the second half of its children is cut, the tree layed out and the children 
+//appended again. Columns deep in the tree cover the ancestors that only move their children after the chain.
+bool checkAppendedLayout() {
+    CorpusGenerator generator;
+    TestMeasurementContext measurementContext;
+    LayoutContext layoutContext;
+    std::vector<Container*> columns;
+    int appendCount = 0;
+    int fastPathCount = 0;
+    bool passed = true;
+
+    for(int i = 0; i < CorpusTreeCount; i++) {
+        Container* root = generator.createTree();
+        layout(root, &measurementContext, &layoutContext);
+        std::ostringstream expected;
+        writeElement(root, expected);
+
+        columns.clear();
+        findColumns(root, columns);
+        for(Container* column: columns) {
+            size_t firstNewChild = column->children.size() / 2;
+            std::vector<BaseElement*> appended(column->children.begin() + firstNewChild, column->children.end());
+            column->children.resize(firstNewChild);
+            layout(root, &measurementContext, &layoutContext);
+            column->children.insert(column->children.end(), appended.begin(), appended.end());
+            if(layoutAppended(column, firstNewChild, &measurementContext, &layoutContext)) fastPathCount++;
+            appendCount++;
+
+            std::ostringstream actual;
+            writeElement(root, actual);
+            passed = check(actual.str() == expected.str(), "layoutAppended differs from layout on a corpus tree") && passed;
+        }
+        destroyElement<int16_t>(root);
+    }
+
+    //both the fast path and the fallback have to be taken for the comparison to cover them
+    passed = check(fastPathCount > 0, "layoutAppended never took the fast path on the corpus") && passed;
+    passed = check(fastPathCount < appendCount, "layoutAppended never fell back to a full layout on the corpus") && passed;
+    return passed;
+}
+
+//a column appended to inside a column of fixed height, which is exactly its content height for one of the heights 
+//tried. A fixed height must not be taken for a content height, the children after the chain still grow.
+bool checkAppendedUnderFixedHeight() {
+    Style columnStyle;
+    columnStyle.layoutDirection = LayoutColumn;
+    StyleHandle column = internStyle(columnStyle);
+    const char* texts[] = {"first", "footer", "below", "x"};
+
+    TestMeasurementContext measurementContext;
+    LayoutContext layoutContext;
+    bool passed = true;
+
+    for(int16_t height = 10; height <= 80; height += 2) {
+        Container root;
+        root.layout.x = 0;
+        root.layout.y = 0;
+        root.width = 300;
+        root.style = column;
+        Container* outer = new Container();
+        outer->style = column;
+        outer->height = height;
+        Container* inner = new Container();
+        inner->style = column;
+        Text* text[4];
+        for(int i = 0; i < 4; i++) {
+            text[i] = new Text();
+            text[i]->text = texts[i];
+        }
+        root.children.push_back(outer);
+        root.children.push_back(text[2]);
+        outer->children.push_back(inner);
+        outer->children.push_back(text[1]);
+        inner->children.push_back(text[0]);
+        inner->children.push_back(text[3]);
+
+        layout(&root, &measurementContext, &layoutContext);
+        std::ostringstream expected;
+        writeElement(&root, expected);
+
+        inner->children.pop_back();
+        layout(&root, &measurementContext, &layoutContext);
+        inner->children.push_back(text[3]);
+        layoutAppended(inner, 1, &measurementContext, &layoutContext);
+        std::ostringstream actual;
+        writeElement(&root, actual);
+        passed = check(actual.str() == expected.str(), "layoutAppended differs from layout under a fixed height column") && passed;
+
+        for(BaseElement* child: root.children) destroyElement<int16_t>(child);
+        root.children.clear();
+    }
+    return passed;
+}
+
+//the box and the lines of every element as the breakpoint layout kept them for a width
+void writeBreakpointResult(const BreakpointLayout& breakpoints, size_t index, std::ostream& out) {
+    for(size_t element = 0; element < breakpoints.getElementCount(); element++) {
+        const ComputedLayout& layout = breakpoints.getLayout(index, element);
+        out << layout.x << ' ' << layout.y << ' ' << layout.width << ' ' << layout.height << ' ' << layout.minWidth << ' ' << layout.minHeight;
+        for(uint32_t line = 0; line < breakpoints.getLineCount(index, element); line++) {
+            uint32_t length;
+            const char* text = breakpoints.getLine(index, element, line, &length);
+            out << '|' << std::string(text, length);
+        }
+        out << '\n';
+    }
+}
+
+//the same for the tree after layout()
+void writeLaidOutTree(BaseElement* element, std::ostream& out) {
+    const ComputedLayout& layout = element->layout;
+    out << layout.x << ' ' << layout.y << ' ' << layout.width << ' ' << layout.height << ' ' << layout.minWidth << ' ' << layout.minHeight;
+    if(element->elementType == ElementTypeText) {
+        for(const std::string& line: ((Text*)element)->wrappedText) out << '|' << line;
+    }
+    out << '\n';
+
+    if(isContainerType(element->elementType)) {
+        for(BaseElement* child: ((Container*)element)->children) writeLaidOutTree(child, out);
+    }
+}
+
+//each width's result matches layout() with the root that wide. 40 is below the fit width of nearly all the corpus 
+//trees, so the copies are restored from the shared fit and then shrunk. The tree is left as layout() leaves it at the
+//first width.
+bool checkBreakpointLayout() {
+    CorpusGenerator generator;
+    TestMeasurementContextFactory factory;
+    TestMeasurementContext measurementContext;
+    LayoutContext layoutContext;
+    BreakpointLayout breakpoints(&factory, 2);
+    bool passed = true;
+
+    for(int i = 0; i < CorpusTreeCount; i++) {
+        Container* root = generator.createTree();
+        int16_t rootWidth = root->width;
+        int16_t widths[4] = {rootWidth, (int16_t)(rootWidth / 2), (int16_t)(rootWidth + 100), 40};
+        breakpoints.layout(root, widths, 4);
+        passed = check(root->width == rootWidth, "the breakpoint layout changed the root's width") && passed;
+
+        std::ostringstream source;
+        writeLaidOutTree(root, source);
+        root->width = widths[0];
+        layout(root, &measurementContext, &layoutContext);
+        std::ostringstream first;
+        writeLaidOutTree(root, first);
+        passed = check(source.str() == first.str(), "the breakpoint layout left the tree unlike layout at the first width") && passed;
+
+        for(size_t index = 0; index < 4; index++) {
+            root->width = widths[index];
+            layout(root, &measurementContext, &layoutContext);
+            std::ostringstream expected, actual;
+            writeLaidOutTree(root, expected);
+            writeBreakpointResult(breakpoints, index, actual);
+            passed = check(actual.str() == expected.str(), "a breakpoint result differs from layout at its width") && passed;
+        }
+        root->width = rootWidth;
+        destroyElement<int16_t>(root);
+    }
+    return passed;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if(argc < 2) {
+        fprintf(stderr, "usage: %s <golden file> [--update]\n", argv[0]);
+        return 1;
+    }
+
+    std::string actual = layoutCorpus();
+
+    if(argc > 2 && strcmp(argv[2], "--update") == 0) {
+        std::ofstream golden(argv[1], std::ios::binary);
+        golden << actual;
+        printf("layout corpus: wrote %s\n", argv[1]);
+        return golden ? 0 : 1;
+    }
+
+    std::ifstream golden(argv[1], std::ios::binary);
+    if(!golden) {
+        fprintf(stderr, "layout corpus: can't read %s\n", argv[1]);
+        return 1;
+    }
+    std::stringstream expected;
+    expected << golden.rdbuf();
+
+    bool passed = compareCorpus(expected.str(), actual);
+    passed = checkTextHeight() && passed;
+    passed = checkGrownHeights() && passed;
+    passed = checkAppendedLayout() && passed;
+    passed = checkAppendedUnderFixedHeight() && passed;
+    passed = checkBreakpointLayout() && passed;
+    if(passed) printf("layout corpus: %d trees match\n", CorpusTreeCount);
+    return passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+//Replays a recorded layout and times each pass. The recording is made with MeasurementRecorder, the measurements are
+//answered from it so the run is deterministic and doesn't need the fonts.
+//
+//Build: the replayLayout target of the CMake build
+//Usage: replayLayout <recording> [iterations]
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "tinyLayoutEngine.hpp"
+#include "tinyLayoutEngineRecording.hpp"
+
+using namespace TinyLayoutEngine;
+
+int main(int argc, char** argv) {
+
+    if(argc < 2) {
+        fprintf(stderr, "usage: %s <recording> [iterations]\n", argv[0]);
+        return 1;
+    }
+    int iterations = argc > 2 ? atoi(argv[2]) : 100;
+    if(iterations < 1) {
+        iterations = 1;
+    }
+
+    MeasurementReplay replay;
+    if(!replay.load(argv[1])) {
+        fprintf(stderr, "%s is not a valid recording\n", argv[1]);
+        return 1;
+    }
+
+    //the first layout warms up the context and checks the recording covers every measurement
+    Container* root = replay.copyTree();
+    LayoutContext layoutContext;
+    layout(root, &replay, &layoutContext);
+    if(replay.getMissCount() > 0) {
+        fprintf(stderr, "warning: %u measurements were not in the recording, the replay diverged\n", replay.getMissCount());
+    }
+
+    double passSeconds[LayoutPassCount] = {};
+    for(int i = 0; i < iterations; i++) {
+        layoutProfiled(root, &replay, &layoutContext, passSeconds);
+    }
+
+    const char* passNames[LayoutPassCount] = {
+        "init", "fit width", "grow width", "wrap", "fit height", "grow height", "positions"
+    };
+    double totalSeconds = 0;
+    for(int pass = 0; pass < LayoutPassCount; pass++) {
+        totalSeconds += passSeconds[pass];
+    }
+
+    printf("%d iterations, mean per layout\n", iterations);
+    for(int pass = 0; pass < LayoutPassCount; pass++) {
+        printf("  %-12s %10.3f us  %5.1f%%\n", passNames[pass], passSeconds[pass] / iterations * 1e6,
+            totalSeconds > 0 ? passSeconds[pass] / totalSeconds * 100 : 0.0);
+    }
+    printf("  %-12s %10.3f us\n", "total", totalSeconds / iterations * 1e6);
+
+    destroyElement(root);
+    return 0;
+}
\ No newline at end of file